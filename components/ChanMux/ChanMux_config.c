@@ -57,19 +57,20 @@ resolveChannel(
 }
 
 //------------------------------------------------------------------------------
+// Only the channels of the single NIC driver are wired (index 0 below), so
+// FIFO memory is reserved for one NIC only.
 static struct
 {
     uint8_t ctrl[128];
-    // FIFO is big enough to store 1 minute of network "background" traffic.
-    // Value found by manual testing, may differ in less noisy networks.
-    uint8_t data[1024 * PAGE_SIZE];
-} nic_fifo[2];
+    // See CHANMUX_NIC_DATA_FIFO_SIZE.
+    uint8_t data[CHANMUX_NIC_DATA_FIFO_SIZE];
+} nic_fifo[1];
 
 static struct
 {
     ChanMux_Channel_t ctrl;
     ChanMux_Channel_t data;
-} nic_channel[2];
+} nic_channel[1];
 
 //------------------------------------------------------------------------------
 static const ChanMux_ChannelCtx_t channelCtx[] =
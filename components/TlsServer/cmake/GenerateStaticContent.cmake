@@ -0,0 +1,200 @@
+#
+# Generate the static content table of the TLS Server
+#
+# Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+# 
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+# Usage: cmake -DCONTENT_DIR=<dir> -DOUTPUT_FILE=<file.c> -P <this script>
+#
+# Every file below CONTENT_DIR is served under its relative path, an
+# "index.html" also under the path of its directory. The generated table is
+# sorted by path and holds the complete response headers, so the TLS Server
+# sends everything straight from read-only memory. The keep-alive header of a
+# file is placed right in front of its body, so both go out in one record
+# without copying them together.
+#
+
+cmake_minimum_required(VERSION 3.17)
+
+if(NOT CONTENT_DIR OR NOT OUTPUT_FILE)
+    message(FATAL_ERROR "CONTENT_DIR and OUTPUT_FILE must be set")
+endif()
+
+get_filename_component(CONTENT_DIR "${CONTENT_DIR}" ABSOLUTE)
+
+#-------------------------------------------------------------------------------
+function(get_content_type file result)
+    get_filename_component(ext "${file}" LAST_EXT)
+    string(TOLOWER "${ext}" ext)
+
+    if(ext STREQUAL ".html" OR ext STREQUAL ".htm")
+        set(type "text/html")
+    elseif(ext STREQUAL ".txt")
+        set(type "text/plain")
+    elseif(ext STREQUAL ".css")
+        set(type "text/css")
+    elseif(ext STREQUAL ".js")
+        set(type "text/javascript")
+    elseif(ext STREQUAL ".json")
+        set(type "application/json")
+    elseif(ext STREQUAL ".svg")
+        set(type "image/svg+xml")
+    elseif(ext STREQUAL ".png")
+        set(type "image/png")
+    elseif(ext STREQUAL ".jpg" OR ext STREQUAL ".jpeg")
+        set(type "image/jpeg")
+    elseif(ext STREQUAL ".ico")
+        set(type "image/x-icon")
+    else()
+        set(type "application/octet-stream")
+    endif()
+
+    set(${result} "${type}" PARENT_SCOPE)
+endfunction()
+
+#-------------------------------------------------------------------------------
+# Collect the paths to serve, sorted bytewise as the lookup expects.
+
+file(GLOB_RECURSE files RELATIVE "${CONTENT_DIR}" "${CONTENT_DIR}/*")
+list(SORT files)
+
+set(paths "")
+foreach(file IN LISTS files)
+    list(APPEND paths "/${file}")
+
+    get_filename_component(name "${file}" NAME)
+    if(name STREQUAL "index.html")
+        get_filename_component(dir "${file}" DIRECTORY)
+        if(dir STREQUAL "")
+            list(APPEND paths "/")
+        else()
+            list(APPEND paths "/${dir}/")
+        endif()
+    endif()
+endforeach()
+list(SORT paths)
+
+# CMake regular expressions have no repetition counts.
+set(bytes_per_line "")
+foreach(i RANGE 1 12)
+    string(APPEND bytes_per_line "0x[0-9a-f][0-9a-f],")
+endforeach()
+
+#-------------------------------------------------------------------------------
+# Emit the data of every file once.
+
+set(out "/*\n * Generated by GenerateStaticContent.cmake, do not edit.\n */\n\n")
+string(APPEND out "#include \"StaticContent.h\"\n\n")
+
+set(index 0)
+foreach(file IN LISTS files)
+    set(path "${CONTENT_DIR}/${file}")
+
+    file(SIZE "${path}" size)
+    file(SHA1 "${path}" hash)
+    string(SUBSTRING "${hash}" 0 16 etag)
+    get_content_type("${file}" type)
+
+    file(READ "${path}" hex HEX)
+    set(array_size ${size})
+    if(size EQUAL 0)
+        set(hex "00")
+        set(array_size 1)
+    endif()
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," bytes "${hex}")
+    string(REGEX REPLACE "(${bytes_per_line})" "\\1\n    " bytes "${bytes}")
+    string(STRIP "${bytes}" bytes)
+
+    set(prefix "content${index}")
+    string(APPEND out "// /${file}\n")
+
+    foreach(conn IN ITEMS close keep-alive)
+        string(REPLACE "-" "_" suffix "${conn}")
+        string(CONCAT header
+            "    \"HTTP/1.1 200 OK\\r\\n\"\n"
+            "    \"Content-Type: ${type}\\r\\n\"\n"
+            "    \"Content-Length: ${size}\\r\\n\"\n"
+            "    \"ETag: \\\"${etag}\\\"\\r\\n\"\n"
+            "    \"Connection: ${conn}\\r\\n\"\n"
+            "    \"\\r\\n\"")
+        if(conn STREQUAL "close")
+            string(APPEND out
+                "static const char ${prefix}_header_${suffix}[] =\n"
+                "${header};\n")
+        else()
+            # Members of type char and uint8_t need no padding in between.
+            string(REPLACE "    \"" "        \"" member "${header}")
+            string(REPLACE "\n    " "\n        " body "${bytes}")
+            string(APPEND out
+                "static const struct\n{\n"
+                "    char    header[sizeof(\n${member}) - 1];\n"
+                "    uint8_t body[${array_size}];\n"
+                "}\n${prefix}_response =\n{\n"
+                "    .header =\n${member},\n"
+                "    .body =\n    {\n        ${body}\n    }\n};\n")
+        endif()
+        string(APPEND out
+            "static const char ${prefix}_not_modified_${suffix}[] =\n"
+            "    \"HTTP/1.1 304 Not Modified\\r\\n\"\n"
+            "    \"ETag: \\\"${etag}\\\"\\r\\n\"\n"
+            "    \"Connection: ${conn}\\r\\n\"\n"
+            "    \"\\r\\n\";\n")
+    endforeach()
+    string(APPEND out "\n")
+
+    set(file_${index}_size ${size})
+    set(file_${index}_etag ${etag})
+    math(EXPR index "${index} + 1")
+endforeach()
+
+#-------------------------------------------------------------------------------
+# Emit the table.
+
+list(LENGTH paths num_entries)
+
+string(APPEND out "const StaticContent_Entry_t StaticContent_entries[] =\n{\n")
+
+# C does not allow an empty initializer, so an empty content directory gets a
+# placeholder entry, which is not counted.
+if(num_entries EQUAL 0)
+    string(APPEND out "    { .path = \"\", .pathLen = 0 },\n")
+endif()
+
+foreach(path IN LISTS paths)
+    string(SUBSTRING "${path}" 1 -1 file)
+    if(path MATCHES "/$")
+        string(APPEND file "index.html")
+    endif()
+    list(FIND files "${file}" index)
+
+    set(prefix "content${index}")
+    string(APPEND out
+        "    {\n"
+        "        .path       = \"${path}\",\n"
+        "        .pathLen    = sizeof(\"${path}\") - 1,\n"
+        "        .etag       = \"\\\"${file_${index}_etag}\\\"\",\n"
+        "        .etagLen    = sizeof(\"\\\"${file_${index}_etag}\\\"\") - 1,\n"
+        "        .body       = ${prefix}_response.body,\n"
+        "        .bodyLen    = ${file_${index}_size},\n"
+        "        .header     = { ${prefix}_header_close, ${prefix}_response.header },\n"
+        "        .headerLen  = { sizeof(${prefix}_header_close) - 1,\n"
+        "                        sizeof(${prefix}_response.header) },\n"
+        "        .notModified    = { ${prefix}_not_modified_close,\n"
+        "                            ${prefix}_not_modified_keep_alive },\n"
+        "        .notModifiedLen = { sizeof(${prefix}_not_modified_close) - 1,\n"
+        "                            sizeof(${prefix}_not_modified_keep_alive) - 1 },\n"
+        "    },\n")
+endforeach()
+string(APPEND out "};\n\n")
+string(APPEND out "const size_t StaticContent_numEntries = ${num_entries};\n")
+
+# Only touch the output if something changed to avoid needless rebuilds.
+if(EXISTS "${OUTPUT_FILE}")
+    file(READ "${OUTPUT_FILE}" old)
+endif()
+if(NOT old STREQUAL out)
+    file(WRITE "${OUTPUT_FILE}" "${out}")
+endif()
@@ -0,0 +1,39 @@
+/*
+ * Host shim of the crypto API, a CTR-DRBG seeded from the entropy interface
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Error.h"
+#include "interfaces/if_OS_Entropy.h"
+
+typedef struct OS_Crypto OS_Crypto_t;
+typedef OS_Crypto_t* OS_Crypto_Handle_t;
+
+typedef enum
+{
+    OS_Crypto_MODE_LIBRARY
+}
+OS_Crypto_Mode_t;
+
+typedef struct
+{
+    OS_Crypto_Mode_t mode;
+    if_OS_Entropy_t  entropy;
+}
+OS_Crypto_Config_t;
+
+OS_Error_t
+OS_Crypto_init(
+    OS_Crypto_Handle_t* const       self,
+    const OS_Crypto_Config_t* const cfg);
+
+OS_Error_t
+OS_Crypto_free(
+    OS_Crypto_Handle_t self);
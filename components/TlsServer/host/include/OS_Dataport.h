@@ -0,0 +1,28 @@
+/*
+ * Host shim of the dataport abstraction
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#define HOST_DATAPORT_SIZE 4096
+
+typedef struct
+{
+    void** io;
+    size_t size;
+}
+OS_Dataport_t;
+
+#define OS_DATAPORT_ASSIGN(_port_) \
+    { .io = (void**) &(_port_), .size = HOST_DATAPORT_SIZE }
+
+#define OS_Dataport_getBuf(_dp_)    (*((_dp_).io))
+#define OS_Dataport_getSize(_dp_)   ((_dp_).size)
@@ -0,0 +1,36 @@
+/*
+ * Host shim of the OS error codes
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+// Subset of the SDK error codes that the TLS server and the shims use, the
+// values are not the ones of the SDK.
+typedef enum
+{
+    OS_ERROR_NETWORK_CONN_RESET     = -17,
+    OS_ERROR_NOT_FOUND              = -16,
+    OS_ERROR_NOT_SUPPORTED          = -15,
+    OS_ERROR_BUFFER_TOO_SMALL       = -14,
+    OS_ERROR_OUT_OF_BOUNDS          = -13,
+    OS_ERROR_TIMEOUT                = -12,
+    OS_ERROR_INVALID_PARAMETER      = -11,
+    OS_ERROR_INSUFFICIENT_SPACE     = -10,
+    OS_ERROR_NETWORK_CONN_SHUTDOWN  = -9,
+    OS_ERROR_WOULD_BLOCK            = -8,
+    OS_ERROR_TRY_AGAIN              = -7,
+    OS_ERROR_CONNECTION_CLOSED      = -6,
+    OS_ERROR_NETWORK_CONN_REFUSED   = -5,
+    OS_ERROR_INVALID_HANDLE         = -4,
+    OS_ERROR_INVALID_STATE          = -3,
+    OS_ERROR_ABORTED                = -2,
+    OS_ERROR_GENERIC                = -1,
+    OS_SUCCESS                      = 0
+}
+OS_Error_t;
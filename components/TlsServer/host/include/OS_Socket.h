@@ -0,0 +1,137 @@
+/*
+ * Host shim of the socket API, based on non-blocking POSIX sockets and epoll
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OS_AF_INET          2
+#define OS_SOCK_STREAM      1
+
+#define OS_INADDR_ANY_STR   "0.0.0.0"
+#define IP_ADD_STR_MAX_LEN  16
+
+// Socket events, see OS_Socket_getPendingEvents().
+#define OS_SOCK_EV_NONE         0
+#define OS_SOCK_EV_CONN_EST     (1 << 0)
+#define OS_SOCK_EV_CONN_ACPT    (1 << 1)
+#define OS_SOCK_EV_READ         (1 << 2)
+#define OS_SOCK_EV_WRITE        (1 << 3)
+#define OS_SOCK_EV_FIN          (1 << 4)
+#define OS_SOCK_EV_CLOSE        (1 << 5)
+#define OS_SOCK_EV_ERROR        (1 << 6)
+
+typedef enum
+{
+    UNINITIALIZED,
+    INITIALIZED,
+    RUNNING,
+    FATAL_ERROR
+}
+OS_NetworkStack_State_t;
+
+typedef struct
+{
+    int unused;
+}
+if_OS_Socket_t;
+
+// The CAmkES interface does not exist on the host.
+#define IF_OS_SOCKET_ASSIGN(_prefix_) { .unused = 0 }
+
+typedef struct
+{
+    if_OS_Socket_t ctx;
+    int            handleID;
+}
+OS_Socket_Handle_t;
+
+typedef struct
+{
+    char     addr[IP_ADD_STR_MAX_LEN];
+    uint16_t port;
+}
+OS_Socket_Addr_t;
+
+typedef struct
+{
+    int        socketHandle;
+    int        parentSocketHandle;
+    uint8_t    eventMask;
+    OS_Error_t currentError;
+}
+OS_Socket_Evt_t;
+
+OS_NetworkStack_State_t
+OS_Socket_getStatus(
+    const if_OS_Socket_t* const ctx);
+
+OS_Error_t
+OS_Socket_create(
+    const if_OS_Socket_t* const ctx,
+    OS_Socket_Handle_t* const   phandle,
+    const int                   domain,
+    const int                   type);
+
+OS_Error_t
+OS_Socket_bind(
+    const OS_Socket_Handle_t      handle,
+    const OS_Socket_Addr_t* const localAddr);
+
+OS_Error_t
+OS_Socket_listen(
+    const OS_Socket_Handle_t handle,
+    const int                backlog);
+
+OS_Error_t
+OS_Socket_accept(
+    const OS_Socket_Handle_t  handle,
+    OS_Socket_Handle_t* const phSocket,
+    OS_Socket_Addr_t* const   srcAddr);
+
+OS_Error_t
+OS_Socket_close(
+    const OS_Socket_Handle_t handle);
+
+OS_Error_t
+OS_Socket_read(
+    const OS_Socket_Handle_t handle,
+    void* const              buf,
+    const size_t             requestedLen,
+    size_t* const            actualLen);
+
+OS_Error_t
+OS_Socket_write(
+    const OS_Socket_Handle_t handle,
+    const void* const        buf,
+    const size_t             requestedLen,
+    size_t* const            actualLen);
+
+/**
+ * Block until at least one socket has an event.
+ */
+OS_Error_t
+OS_Socket_wait(
+    const if_OS_Socket_t* const ctx);
+
+/**
+ * Fetch the events of all sockets, at most one OS_Socket_Evt_t per socket.
+ * Events are edge triggered like the ones of the network stack: a socket
+ * reports OS_SOCK_EV_READ or OS_SOCK_EV_WRITE again only after it changed.
+ */
+OS_Error_t
+OS_Socket_getPendingEvents(
+    const if_OS_Socket_t* const ctx,
+    void* const                 buf,
+    const size_t                bufSize,
+    int* const                  pNumberOfEvents);
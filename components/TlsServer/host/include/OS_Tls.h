@@ -0,0 +1,118 @@
+/*
+ * Host shim of the TLS API, based on mbedTLS
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Crypto.h"
+#include "OS_Error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct OS_Tls OS_Tls_t;
+typedef OS_Tls_t* OS_Tls_Handle_t;
+
+typedef enum
+{
+    OS_Tls_MODE_LIBRARY
+}
+OS_Tls_Mode_t;
+
+typedef enum
+{
+    OS_Tls_FLAG_NONE        = 0,
+    OS_Tls_FLAG_DEBUG       = (1 << 0),
+    OS_Tls_FLAG_NO_VERIFY   = (1 << 1)
+}
+OS_Tls_Flag_t;
+
+// IANA values of the cipher suites the SDK supports.
+typedef enum
+{
+    OS_Tls_CIPHERSUITE_NONE                             = 0x0000,
+    OS_Tls_CIPHERSUITE_DHE_RSA_WITH_AES_128_GCM_SHA256   = 0x009e,
+    OS_Tls_CIPHERSUITE_ECDHE_RSA_WITH_AES_128_GCM_SHA256 = 0xc02f
+}
+OS_Tls_CipherSuite_t;
+
+typedef uint32_t OS_Tls_CipherSuite_Flags_t;
+
+#define OS_Tls_CIPHERSUITE_FLAGS(...)                                   \
+    OS_Tls_getCipherSuiteFlags(                                         \
+        (const OS_Tls_CipherSuite_t[]) { __VA_ARGS__, OS_Tls_CIPHERSUITE_NONE })
+
+typedef struct
+{
+    int unused;
+}
+OS_Tls_Policy_t;
+
+typedef struct
+{
+    OS_Tls_Mode_t mode;
+    struct
+    {
+        struct
+        {
+            // Points to the OS_Socket_Handle_t of the connection.
+            void* context;
+        }
+        socket;
+        OS_Tls_Flag_t flags;
+        struct
+        {
+            OS_Crypto_Handle_t         handle;
+            const OS_Tls_Policy_t*     policy;
+            const char*                caCerts;
+            const char*                ownCert;
+            const char*                privateKey;
+            OS_Tls_CipherSuite_Flags_t cipherSuites;
+        }
+        crypto;
+    }
+    library;
+}
+OS_Tls_Config_t;
+
+/**
+ * Map a list of cipher suites terminated by OS_Tls_CIPHERSUITE_NONE to flags.
+ */
+OS_Tls_CipherSuite_Flags_t
+OS_Tls_getCipherSuiteFlags(
+    const OS_Tls_CipherSuite_t* suites);
+
+OS_Error_t
+OS_Tls_init(
+    OS_Tls_Handle_t* const       self,
+    const OS_Tls_Config_t* const cfg);
+
+OS_Error_t
+OS_Tls_free(
+    OS_Tls_Handle_t self);
+
+OS_Error_t
+OS_Tls_handshake(
+    OS_Tls_Handle_t self);
+
+OS_Error_t
+OS_Tls_read(
+    OS_Tls_Handle_t self,
+    void* const     data,
+    size_t* const   dataSize);
+
+OS_Error_t
+OS_Tls_write(
+    OS_Tls_Handle_t   self,
+    const void* const data,
+    size_t* const     dataSize);
+
+OS_Error_t
+OS_Tls_reset(
+    OS_Tls_Handle_t self);
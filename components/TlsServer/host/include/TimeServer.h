@@ -0,0 +1,45 @@
+/*
+ * Host shim of the TimeServer client, based on the monotonic clock
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Error.h"
+
+#include <stdint.h>
+
+typedef struct
+{
+    int unused;
+}
+if_OS_Timer_t;
+
+// The CAmkES interfaces do not exist on the host.
+#define IF_OS_TIMER_ASSIGN(_rpc_, _evt_) { .unused = 0 }
+
+typedef enum
+{
+    TimeServer_PRECISION_SEC,
+    TimeServer_PRECISION_MSEC,
+    TimeServer_PRECISION_USEC,
+    TimeServer_PRECISION_NSEC
+}
+TimeServer_Precision_t;
+
+OS_Error_t
+TimeServer_getTime(
+    const if_OS_Timer_t*         timer,
+    const TimeServer_Precision_t precision,
+    uint64_t*                    time);
+
+OS_Error_t
+TimeServer_sleep(
+    const if_OS_Timer_t*         timer,
+    const TimeServer_Precision_t precision,
+    const uint64_t               time);
@@ -0,0 +1,58 @@
+/*
+ * Host shim of the CAmkES glue code
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Entropy dataport and RPC, served from /dev/urandom.
+extern void* entropy_port;
+
+size_t
+entropy_rpc_read(
+    const size_t len);
+
+// Worker index attribute, set from the command line to run several workers.
+extern int worker_id;
+
+// Event log notification, the callback runs in a thread of idle priority.
+void
+eventLog_signal_emit(void);
+
+int
+eventLog_notify_reg_callback(
+    void (*callback)(void*),
+    void* arg);
+
+// Mutex of the component.
+int
+loopLock_lock(void);
+
+int
+loopLock_unlock(void);
+
+// Periodic timer of the TimeServer, the callback runs in a thread of its own.
+int
+timeServer_rpc_periodic(
+    const int      id,
+    const uint64_t ns);
+
+unsigned int
+timeServer_rpc_completed(void);
+
+int
+timeServer_notify_reg_callback(
+    void (*callback)(void*),
+    void* arg);
+
+// Component entry point, called by main().
+int
+run(void);
@@ -0,0 +1,15 @@
+/*
+ * Host shim of the compiler helpers
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#define ARRAY_SIZE(_arr_) (sizeof(_arr_) / sizeof((_arr_)[0]))
+
+#define UNUSED __attribute__((unused))
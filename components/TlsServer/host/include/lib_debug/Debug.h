@@ -0,0 +1,60 @@
+/*
+ * Host shim of the debug library, logs to stderr
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <assert.h>
+#include <stdio.h>
+
+#define Debug_LOG_LEVEL_NONE        0
+#define Debug_LOG_LEVEL_ASSERT      1
+#define Debug_LOG_LEVEL_FATAL       2
+#define Debug_LOG_LEVEL_ERROR       3
+#define Debug_LOG_LEVEL_WARNING     4
+#define Debug_LOG_LEVEL_INFO        5
+#define Debug_LOG_LEVEL_DEBUG       6
+#define Debug_LOG_LEVEL_TRACE       7
+
+// The level of system_config.h can be overruled for profiling, where logging
+// every request would dominate.
+#if defined(Debug_Config_HOST_LOG_LEVEL)
+#   define Debug_LOG_LEVEL_ACTIVE   Debug_Config_HOST_LOG_LEVEL
+#elif defined(Debug_Config_LOG_LEVEL)
+#   define Debug_LOG_LEVEL_ACTIVE   Debug_Config_LOG_LEVEL
+#else
+#   define Debug_LOG_LEVEL_ACTIVE   Debug_LOG_LEVEL_INFO
+#endif
+
+// The lock keeps the lines of several threads apart.
+#define Debug_LOG(_level_, _name_, ...)                             \
+    do                                                              \
+    {                                                               \
+        if ((_level_) <= Debug_LOG_LEVEL_ACTIVE)                    \
+        {                                                           \
+            flockfile(stderr);                                      \
+            fprintf(stderr, _name_ " %s:%d: ", __FILE__, __LINE__); \
+            fprintf(stderr, __VA_ARGS__);                           \
+            fputc('\n', stderr);                                    \
+            funlockfile(stderr);                                    \
+        }                                                           \
+    } while (0)
+
+#define Debug_LOG_ERROR(...) \
+    Debug_LOG(Debug_LOG_LEVEL_ERROR, "ERROR", __VA_ARGS__)
+#define Debug_LOG_WARNING(...) \
+    Debug_LOG(Debug_LOG_LEVEL_WARNING, "WARNING", __VA_ARGS__)
+#define Debug_LOG_INFO(...) \
+    Debug_LOG(Debug_LOG_LEVEL_INFO, "INFO", __VA_ARGS__)
+#define Debug_LOG_DEBUG(...) \
+    Debug_LOG(Debug_LOG_LEVEL_DEBUG, "DEBUG", __VA_ARGS__)
+#define Debug_LOG_TRACE(...) \
+    Debug_LOG(Debug_LOG_LEVEL_TRACE, "TRACE", __VA_ARGS__)
+
+#define Debug_ASSERT(_cond_)    assert(_cond_)
@@ -0,0 +1,122 @@
+/*
+ * Host shim of the crypto API, a CTR-DRBG seeded from the entropy interface
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "HostCrypto.h"
+
+#include "lib_debug/Debug.h"
+
+#include "mbedtls/version.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+
+// Entropy callback of the DRBG, reads through the dataport like the crypto
+// library of the SDK does.
+static int
+readEntropy(
+    void*          ctx,
+    unsigned char* buf,
+    size_t         len)
+{
+    const OS_Crypto_t* const self = ctx;
+    const size_t portSize = OS_Dataport_getSize(self->entropy.dataport);
+
+    while (len > 0)
+    {
+        const size_t chunk = (len < portSize) ? len : portSize;
+
+        if (self->entropy.read(chunk) != chunk)
+        {
+            return MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+        }
+        memcpy(buf, OS_Dataport_getBuf(self->entropy.dataport), chunk);
+
+        buf += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+
+int
+HostCrypto_getRandom(
+    void*          ctx,
+    unsigned char* buf,
+    size_t         len)
+{
+    OS_Crypto_t* const self = ctx;
+
+    return mbedtls_ctr_drbg_random(&self->drbg, buf, len);
+}
+
+OS_Error_t
+OS_Crypto_init(
+    OS_Crypto_Handle_t* const       self,
+    const OS_Crypto_Config_t* const cfg)
+{
+    if ((NULL == self) || (NULL == cfg) || (NULL == cfg->entropy.read))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    // A library of another branch than the headers would misinterpret the
+    // layout of every context, see MBEDTLS_REQUIRED_VERSION.
+    if ((mbedtls_version_get_number() >> 16) != (MBEDTLS_VERSION_NUMBER >> 16))
+    {
+        char version[18];
+        mbedtls_version_get_string(version);
+
+        Debug_LOG_ERROR("mbedTLS library %s does not match the headers of %s",
+                        version, MBEDTLS_VERSION_STRING);
+        return OS_ERROR_NOT_SUPPORTED;
+    }
+
+    OS_Crypto_t* const crypto = calloc(1, sizeof(*crypto));
+    if (NULL == crypto)
+    {
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    crypto->entropy = cfg->entropy;
+    mbedtls_ctr_drbg_init(&crypto->drbg);
+
+    const int ret = mbedtls_ctr_drbg_seed(&crypto->drbg, readEntropy, crypto,
+                                          NULL, 0);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("mbedtls_ctr_drbg_seed() failed, code -0x%04x", -ret);
+        mbedtls_ctr_drbg_free(&crypto->drbg);
+        free(crypto);
+        return OS_ERROR_ABORTED;
+    }
+
+    *self = crypto;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+OS_Crypto_free(
+    OS_Crypto_Handle_t self)
+{
+    if (NULL == self)
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    mbedtls_ctr_drbg_free(&self->drbg);
+    free(self);
+
+    return OS_SUCCESS;
+}
@@ -0,0 +1,30 @@
+/*
+ * Host shim of the crypto API, internals shared with the TLS shim
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Crypto.h"
+
+#include "mbedtls/ctr_drbg.h"
+
+struct OS_Crypto
+{
+    if_OS_Entropy_t          entropy;
+    mbedtls_ctr_drbg_context drbg;
+};
+
+/**
+ * Random number generator for mbedTLS, expects the OS_Crypto_t as context.
+ */
+int
+HostCrypto_getRandom(
+    void*          ctx,
+    unsigned char* buf,
+    size_t         len);
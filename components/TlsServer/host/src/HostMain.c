@@ -0,0 +1,360 @@
+/*
+ * Host shim of the CAmkES glue code, the entropy source and the TimeServer
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#define _GNU_SOURCE
+
+#include <camkes.h>
+
+#include "OS_Dataport.h"
+#include "TimeServer.h"
+
+#include "lib_debug/Debug.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+
+static char mEntropyBuf[HOST_DATAPORT_SIZE];
+
+void* entropy_port = mEntropyBuf;
+
+int worker_id = 0;
+
+static int mUrandomFd = -1;
+
+// CAmkES notification, a pending signal is kept until the callback runs.
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    bool            isSignaled;
+    void            (*callback)(void*);
+    void*           arg;
+}
+Notification_t;
+
+#define NOTIFICATION_INIT \
+    { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, false, NULL, NULL }
+
+static Notification_t mEventLogNotification = NOTIFICATION_INIT;
+static Notification_t mTimerNotification = NOTIFICATION_INIT;
+
+// Period of the timer of the TimeServer, 0 until it is started. Only a single
+// periodic timer is supported.
+static pthread_mutex_t mTimerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t mTimerCond = PTHREAD_COND_INITIALIZER;
+static uint64_t mTimerPeriodNs = 0;
+
+static pthread_mutex_t mLoopLock = PTHREAD_MUTEX_INITIALIZER;
+
+//------------------------------------------------------------------------------
+
+size_t
+entropy_rpc_read(
+    const size_t len)
+{
+    const size_t size = (len < sizeof(mEntropyBuf)) ? len : sizeof(mEntropyBuf);
+    size_t pos = 0;
+
+    while (pos < size)
+    {
+        const ssize_t ret = read(mUrandomFd, mEntropyBuf + pos, size - pos);
+        if (ret <= 0)
+        {
+            if ((ret < 0) && (EINTR == errno))
+            {
+                continue;
+            }
+            Debug_LOG_ERROR("Reading /dev/urandom failed, errno %d", errno);
+            break;
+        }
+        pos += (size_t)ret;
+    }
+
+    return pos;
+}
+
+//------------------------------------------------------------------------------
+
+static void
+emitNotification(
+    Notification_t* const notification)
+{
+    pthread_mutex_lock(&notification->lock);
+    notification->isSignaled = true;
+    pthread_cond_signal(&notification->cond);
+    pthread_mutex_unlock(&notification->lock);
+}
+
+static int
+registerCallback(
+    Notification_t* const notification,
+    void (*callback)(void*),
+    void* arg)
+{
+    pthread_mutex_lock(&notification->lock);
+    notification->callback = callback;
+    notification->arg = arg;
+    pthread_cond_signal(&notification->cond);
+    pthread_mutex_unlock(&notification->lock);
+
+    return 0;
+}
+
+// Like a CAmkES callback, a registered callback runs once for the next signal.
+static void
+runCallbacks(
+    Notification_t* const notification)
+{
+    for (;;)
+    {
+        pthread_mutex_lock(&notification->lock);
+        while (!notification->isSignaled || (NULL == notification->callback))
+        {
+            pthread_cond_wait(&notification->cond, &notification->lock);
+        }
+        void (*callback)(void*) = notification->callback;
+        void* arg = notification->arg;
+        notification->isSignaled = false;
+        notification->callback = NULL;
+        pthread_mutex_unlock(&notification->lock);
+
+        callback(arg);
+    }
+}
+
+void
+eventLog_signal_emit(void)
+{
+    emitNotification(&mEventLogNotification);
+}
+
+int
+eventLog_notify_reg_callback(
+    void (*callback)(void*),
+    void* arg)
+{
+    return registerCallback(&mEventLogNotification, callback, arg);
+}
+
+// Thread of the eventLog_notify interface.
+static void*
+runEventLogThread(
+    void* ctx)
+{
+    // Stands in for TLS_SERVER_EVENT_LOG_PRIORITY, the thread only runs when
+    // no other thread of the host wants the CPU.
+    const struct sched_param param = { .sched_priority = 0 };
+    const int ret = pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+    if (0 != ret)
+    {
+        Debug_LOG_WARNING("Setting SCHED_IDLE failed, code %d", ret);
+    }
+
+    runCallbacks(&mEventLogNotification);
+
+    return NULL;
+}
+
+int
+loopLock_lock(void)
+{
+    return pthread_mutex_lock(&mLoopLock);
+}
+
+int
+loopLock_unlock(void)
+{
+    return pthread_mutex_unlock(&mLoopLock);
+}
+
+//------------------------------------------------------------------------------
+
+int
+timeServer_rpc_periodic(
+    const int      id,
+    const uint64_t ns)
+{
+    pthread_mutex_lock(&mTimerLock);
+    mTimerPeriodNs = ns;
+    pthread_cond_signal(&mTimerCond);
+    pthread_mutex_unlock(&mTimerLock);
+
+    return 0;
+}
+
+unsigned int
+timeServer_rpc_completed(void)
+{
+    return 1;
+}
+
+int
+timeServer_notify_reg_callback(
+    void (*callback)(void*),
+    void* arg)
+{
+    return registerCallback(&mTimerNotification, callback, arg);
+}
+
+// Thread of the TimeServer, signals timeServer_notify every period.
+static void*
+runTimerThread(
+    void* ctx)
+{
+    pthread_mutex_lock(&mTimerLock);
+    while (0 == mTimerPeriodNs)
+    {
+        pthread_cond_wait(&mTimerCond, &mTimerLock);
+    }
+    const uint64_t ns = mTimerPeriodNs;
+    pthread_mutex_unlock(&mTimerLock);
+
+    struct timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    for (;;)
+    {
+        const uint64_t nextNs = (uint64_t)next.tv_nsec + ns;
+        next.tv_sec += (time_t)(nextNs / 1000000000ULL);
+        next.tv_nsec = (long)(nextNs % 1000000000ULL);
+
+        while (0 != clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next,
+                                    NULL))
+        {
+        }
+
+        emitNotification(&mTimerNotification);
+    }
+
+    return NULL;
+}
+
+// Thread of the timeServer_notify interface.
+static void*
+runTimerNotifyThread(
+    void* ctx)
+{
+    runCallbacks(&mTimerNotification);
+
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+
+static uint64_t
+getDivisor(
+    const TimeServer_Precision_t precision)
+{
+    switch (precision)
+    {
+    case TimeServer_PRECISION_SEC:
+        return 1000000000ULL;
+    case TimeServer_PRECISION_MSEC:
+        return 1000000ULL;
+    case TimeServer_PRECISION_USEC:
+        return 1000ULL;
+    default:
+        return 1ULL;
+    }
+}
+
+OS_Error_t
+TimeServer_getTime(
+    const if_OS_Timer_t*         timer,
+    const TimeServer_Precision_t precision,
+    uint64_t*                    time)
+{
+    struct timespec ts;
+
+    if (0 != clock_gettime(CLOCK_MONOTONIC, &ts))
+    {
+        return OS_ERROR_GENERIC;
+    }
+
+    const uint64_t ns = ((uint64_t)ts.tv_sec * 1000000000ULL)
+                        + (uint64_t)ts.tv_nsec;
+    *time = ns / getDivisor(precision);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+TimeServer_sleep(
+    const if_OS_Timer_t*         timer,
+    const TimeServer_Precision_t precision,
+    const uint64_t               time)
+{
+    const uint64_t ns = time * getDivisor(precision);
+    struct timespec ts =
+    {
+        .tv_sec  = (time_t)(ns / 1000000000ULL),
+        .tv_nsec = (long)(ns % 1000000000ULL)
+    };
+
+    while (0 != nanosleep(&ts, &ts))
+    {
+        if (EINTR != errno)
+        {
+            return OS_ERROR_GENERIC;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+
+int
+main(
+    int   argc,
+    char* argv[])
+{
+    // Every worker is a process of its own, listening on TLS_SERVER_PORT plus
+    // its index.
+    if (argc > 1)
+    {
+        worker_id = atoi(argv[1]);
+    }
+
+    mUrandomFd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (mUrandomFd < 0)
+    {
+        Debug_LOG_ERROR("Opening /dev/urandom failed, errno %d", errno);
+        return 1;
+    }
+
+    // The TlsServer has threads for its notifications, the TimeServer is a
+    // thread of its own.
+    void* (*const threads[])(void*) =
+    {
+        runEventLogThread, runTimerNotifyThread, runTimerThread
+    };
+
+    for (size_t i = 0; i < (sizeof(threads) / sizeof(threads[0])); i++)
+    {
+        pthread_t thread;
+        const int ret = pthread_create(&thread, NULL, threads[i], NULL);
+        if (0 != ret)
+        {
+            Debug_LOG_ERROR("pthread_create() failed, code %d", ret);
+            return 1;
+        }
+    }
+
+    return (0 == run()) ? 0 : 1;
+}
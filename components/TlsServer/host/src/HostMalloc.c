@@ -0,0 +1,98 @@
+/*
+ * Host shim of the heap functions, interposes the ones of glibc so the
+ * allocations of mbedTLS go to the connection arenas as on the target
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "ConnectionArena.h"
+
+#include <stdint.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+
+// Entry points of the glibc allocator, which stay available when malloc() and
+// friends are replaced by the executable.
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t nmemb, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void  __libc_free(void* ptr);
+
+void  free(void* ptr);
+
+//------------------------------------------------------------------------------
+
+void*
+malloc(
+    size_t size)
+{
+    void* const ptr = ConnectionArena_alloc(size);
+
+    return (NULL != ptr) ? ptr : __libc_malloc(size);
+}
+
+void*
+calloc(
+    size_t nmemb,
+    size_t size)
+{
+    if ((0 != size) && (nmemb > (SIZE_MAX / size)))
+    {
+        return NULL;
+    }
+
+    void* const ptr = ConnectionArena_alloc(nmemb * size);
+    if (NULL == ptr)
+    {
+        return __libc_calloc(nmemb, size);
+    }
+
+    memset(ptr, 0, nmemb * size);
+
+    return ptr;
+}
+
+void*
+realloc(
+    void*  ptr,
+    size_t size)
+{
+    const size_t oldSize = ConnectionArena_getSize(ptr);
+    if (0 == oldSize)
+    {
+        return __libc_realloc(ptr, size);
+    }
+    if (0 == size)
+    {
+        free(ptr);
+        return NULL;
+    }
+    if (size <= oldSize)
+    {
+        return ptr;
+    }
+
+    void* const newPtr = malloc(size);
+    if (NULL != newPtr)
+    {
+        memcpy(newPtr, ptr, oldSize);
+        ConnectionArena_free(ptr);
+    }
+
+    return newPtr;
+}
+
+void
+free(
+    void* ptr)
+{
+    if (!ConnectionArena_free(ptr))
+    {
+        __libc_free(ptr);
+    }
+}
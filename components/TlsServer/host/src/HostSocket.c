@@ -0,0 +1,406 @@
+/*
+ * Host shim of the socket API, based on non-blocking POSIX sockets and epoll
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#define _GNU_SOURCE
+
+#include "OS_Socket.h"
+
+#include "lib_debug/Debug.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+
+// Events fetched from epoll but not yet passed on by
+// OS_Socket_getPendingEvents().
+#define MAX_BUFFERED_EVENTS 64
+
+// Listening sockets are tagged in the epoll data, as their readiness means
+// there is a connection to accept.
+#define EPOLL_DATA_LISTENING (1ULL << 32)
+
+//------------------------------------------------------------------------------
+
+static int mEpollFd = -1;
+
+// Level-triggered set holding only mEpollFd, it becomes ready while sockets
+// have events, which OS_Socket_wait() leaves to OS_Socket_getPendingEvents().
+static int mWaitFd = -1;
+
+static struct epoll_event mEvents[MAX_BUFFERED_EVENTS];
+static size_t mNumEvents = 0;
+
+//------------------------------------------------------------------------------
+
+static OS_Error_t
+mapErrno(
+    const int err)
+{
+    switch (err)
+    {
+    case EAGAIN:
+    case EINPROGRESS:
+        return OS_ERROR_TRY_AGAIN;
+    case ECONNRESET:
+    case EPIPE:
+        return OS_ERROR_NETWORK_CONN_SHUTDOWN;
+    case ECONNREFUSED:
+        return OS_ERROR_NETWORK_CONN_REFUSED;
+    case EBADF:
+        return OS_ERROR_INVALID_HANDLE;
+    case EINVAL:
+        return OS_ERROR_INVALID_PARAMETER;
+    default:
+        return OS_ERROR_GENERIC;
+    }
+}
+
+static OS_Error_t
+addToEpoll(
+    const int      fd,
+    const uint32_t events,
+    const uint64_t data)
+{
+    struct epoll_event event =
+    {
+        .events = events | EPOLLET,
+        .data.u64 = data | (uint32_t)fd
+    };
+
+    if (0 != epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event))
+    {
+        Debug_LOG_ERROR("epoll_ctl() failed for fd %d, errno %d", fd, errno);
+        return OS_ERROR_GENERIC;
+    }
+
+    return OS_SUCCESS;
+}
+
+static uint8_t
+mapEvents(
+    const struct epoll_event* const event,
+    OS_Error_t* const               currentError)
+{
+    uint8_t mask = OS_SOCK_EV_NONE;
+
+    *currentError = OS_SUCCESS;
+
+    if (event->data.u64 & EPOLL_DATA_LISTENING)
+    {
+        return (event->events & EPOLLIN) ? OS_SOCK_EV_CONN_ACPT : mask;
+    }
+
+    if (event->events & EPOLLIN)
+    {
+        mask |= OS_SOCK_EV_READ;
+    }
+    if (event->events & EPOLLOUT)
+    {
+        mask |= OS_SOCK_EV_WRITE;
+    }
+    if (event->events & EPOLLRDHUP)
+    {
+        mask |= OS_SOCK_EV_FIN;
+    }
+    if (event->events & EPOLLHUP)
+    {
+        mask |= OS_SOCK_EV_CLOSE;
+    }
+    if (event->events & EPOLLERR)
+    {
+        const int fd = (int)(uint32_t)event->data.u64;
+        int err = 0;
+        socklen_t len = sizeof(err);
+
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        *currentError = mapErrno(err);
+        mask |= OS_SOCK_EV_ERROR;
+    }
+
+    return mask;
+}
+
+//------------------------------------------------------------------------------
+
+OS_NetworkStack_State_t
+OS_Socket_getStatus(
+    const if_OS_Socket_t* const ctx)
+{
+    // The network stack of the host is always up.
+    return RUNNING;
+}
+
+OS_Error_t
+OS_Socket_create(
+    const if_OS_Socket_t* const ctx,
+    OS_Socket_Handle_t* const   phandle,
+    const int                   domain,
+    const int                   type)
+{
+    if ((OS_AF_INET != domain) || (OS_SOCK_STREAM != type))
+    {
+        return OS_ERROR_NOT_SUPPORTED;
+    }
+
+    if (mEpollFd < 0)
+    {
+        mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+        mWaitFd = epoll_create1(EPOLL_CLOEXEC);
+        if ((mEpollFd < 0) || (mWaitFd < 0))
+        {
+            Debug_LOG_ERROR("epoll_create1() failed, errno %d", errno);
+            return OS_ERROR_GENERIC;
+        }
+
+        struct epoll_event event = { .events = EPOLLIN };
+        if (0 != epoll_ctl(mWaitFd, EPOLL_CTL_ADD, mEpollFd, &event))
+        {
+            Debug_LOG_ERROR("epoll_ctl() failed, errno %d", errno);
+            return OS_ERROR_GENERIC;
+        }
+    }
+
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0)
+    {
+        return mapErrno(errno);
+    }
+
+    // Allow restarting the server right away while connections of the previous
+    // run are still in TIME_WAIT.
+    const int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    phandle->ctx      = *ctx;
+    phandle->handleID = fd;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+OS_Socket_bind(
+    const OS_Socket_Handle_t      handle,
+    const OS_Socket_Addr_t* const localAddr)
+{
+    struct sockaddr_in addr =
+    {
+        .sin_family = AF_INET,
+        .sin_port   = htons(localAddr->port)
+    };
+
+    if (1 != inet_pton(AF_INET, localAddr->addr, &addr.sin_addr))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    if (0 != bind(handle.handleID, (struct sockaddr*)&addr, sizeof(addr)))
+    {
+        Debug_LOG_ERROR("bind() failed for port %u, errno %d",
+                        localAddr->port, errno);
+        return mapErrno(errno);
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+OS_Socket_listen(
+    const OS_Socket_Handle_t handle,
+    const int                backlog)
+{
+    if (0 != listen(handle.handleID, backlog))
+    {
+        return mapErrno(errno);
+    }
+
+    return addToEpoll(handle.handleID, EPOLLIN, EPOLL_DATA_LISTENING);
+}
+
+OS_Error_t
+OS_Socket_accept(
+    const OS_Socket_Handle_t  handle,
+    OS_Socket_Handle_t* const phSocket,
+    OS_Socket_Addr_t* const   srcAddr)
+{
+    struct sockaddr_in addr;
+    socklen_t addrLen = sizeof(addr);
+
+    const int fd = accept4(handle.handleID, (struct sockaddr*)&addr, &addrLen,
+                           SOCK_NONBLOCK);
+    if (fd < 0)
+    {
+        return mapErrno(errno);
+    }
+
+    // Header and body usually go out in one record, there is no point in
+    // holding back the last segment of a response.
+    const int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    OS_Error_t err = addToEpoll(fd, EPOLLIN | EPOLLOUT | EPOLLRDHUP, 0);
+    if (OS_SUCCESS != err)
+    {
+        close(fd);
+        return err;
+    }
+
+    inet_ntop(AF_INET, &addr.sin_addr, srcAddr->addr, sizeof(srcAddr->addr));
+    srcAddr->port = ntohs(addr.sin_port);
+
+    phSocket->ctx      = handle.ctx;
+    phSocket->handleID = fd;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+OS_Socket_close(
+    const OS_Socket_Handle_t handle)
+{
+    // The descriptor is reused by the next accept, so buffered events of the
+    // closed socket must not be passed on.
+    size_t n = 0;
+    for (size_t i = 0; i < mNumEvents; i++)
+    {
+        if ((int)(uint32_t)mEvents[i].data.u64 != handle.handleID)
+        {
+            mEvents[n++] = mEvents[i];
+        }
+    }
+    mNumEvents = n;
+
+    // Closing the descriptor removes it from the epoll set as well.
+    if (0 != close(handle.handleID))
+    {
+        return mapErrno(errno);
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+OS_Socket_read(
+    const OS_Socket_Handle_t handle,
+    void* const              buf,
+    const size_t             requestedLen,
+    size_t* const            actualLen)
+{
+    *actualLen = 0;
+
+    const ssize_t ret = recv(handle.handleID, buf, requestedLen, 0);
+    if (ret < 0)
+    {
+        return mapErrno(errno);
+    }
+    if (0 == ret)
+    {
+        return OS_ERROR_CONNECTION_CLOSED;
+    }
+
+    *actualLen = (size_t)ret;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+OS_Socket_write(
+    const OS_Socket_Handle_t handle,
+    const void* const        buf,
+    const size_t             requestedLen,
+    size_t* const            actualLen)
+{
+    *actualLen = 0;
+
+    const ssize_t ret = send(handle.handleID, buf, requestedLen, MSG_NOSIGNAL);
+    if (ret < 0)
+    {
+        return mapErrno(errno);
+    }
+
+    *actualLen = (size_t)ret;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+OS_Socket_wait(
+    const if_OS_Socket_t* const ctx)
+{
+    // The TlsServer waits without holding its lock, while its timer thread may
+    // close sockets. So the buffered events are not touched here, the loop has
+    // taken all of them before it waits.
+    struct epoll_event event;
+
+    while (epoll_wait(mWaitFd, &event, 1, -1) < 0)
+    {
+        if (EINTR != errno)
+        {
+            Debug_LOG_ERROR("epoll_wait() failed, errno %d", errno);
+            return OS_ERROR_GENERIC;
+        }
+    }
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+OS_Socket_getPendingEvents(
+    const if_OS_Socket_t* const ctx,
+    void* const                 buf,
+    const size_t                bufSize,
+    int* const                  pNumberOfEvents)
+{
+    *pNumberOfEvents = 0;
+
+    if (0 == mNumEvents)
+    {
+        const int ret = epoll_wait(mEpollFd, mEvents, MAX_BUFFERED_EVENTS, 0);
+        if (ret < 0)
+        {
+            if (EINTR == errno)
+            {
+                return OS_SUCCESS;
+            }
+            Debug_LOG_ERROR("epoll_wait() failed, errno %d", errno);
+            return OS_ERROR_GENERIC;
+        }
+        mNumEvents = (size_t)ret;
+    }
+
+    // epoll reports every descriptor at most once per call, so there is at
+    // most one event per socket as well.
+    const size_t maxEvents = bufSize / sizeof(OS_Socket_Evt_t);
+    const size_t numEvents = (mNumEvents < maxEvents) ? mNumEvents : maxEvents;
+
+    for (size_t i = 0; i < numEvents; i++)
+    {
+        OS_Socket_Evt_t event;
+
+        event.socketHandle       = (int)(uint32_t)mEvents[i].data.u64;
+        event.parentSocketHandle = -1;
+        event.eventMask          = mapEvents(&mEvents[i], &event.currentError);
+
+        memcpy((char*)buf + (i * sizeof(event)), &event, sizeof(event));
+    }
+
+    mNumEvents -= numEvents;
+    memmove(mEvents, &mEvents[numEvents], mNumEvents * sizeof(mEvents[0]));
+
+    *pNumberOfEvents = (int)numEvents;
+
+    return OS_SUCCESS;
+}
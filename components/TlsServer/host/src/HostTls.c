@@ -0,0 +1,398 @@
+/*
+ * Host shim of the TLS API, based on mbedTLS
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "OS_Tls.h"
+#include "OS_Socket.h"
+#include "HostCrypto.h"
+
+#include "lib_debug/Debug.h"
+
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/x509_crt.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+
+typedef struct
+{
+    OS_Tls_CipherSuite_t suite;
+    OS_Tls_CipherSuite_Flags_t flag;
+}
+CipherSuiteFlag_t;
+
+static const CipherSuiteFlag_t cipherSuiteFlags[] =
+{
+    { OS_Tls_CIPHERSUITE_DHE_RSA_WITH_AES_128_GCM_SHA256,   (1 << 0) },
+    { OS_Tls_CIPHERSUITE_ECDHE_RSA_WITH_AES_128_GCM_SHA256, (1 << 1) },
+};
+
+#define NUM_CIPHERSUITES \
+    (sizeof(cipherSuiteFlags) / sizeof(cipherSuiteFlags[0]))
+
+struct OS_Tls
+{
+    mbedtls_ssl_context ssl;
+    mbedtls_ssl_config  conf;
+    mbedtls_x509_crt    caCerts;
+    mbedtls_x509_crt    ownCert;
+    mbedtls_pk_context  privateKey;
+
+    // The suite list is referenced by the configuration, the IANA values of
+    // OS_Tls_CipherSuite_t are the ones of mbedTLS.
+    int                 cipherSuites[NUM_CIPHERSUITES + 1];
+};
+
+//------------------------------------------------------------------------------
+
+static int
+sendCallback(
+    void*                ctx,
+    const unsigned char* buf,
+    size_t               len)
+{
+    const OS_Socket_Handle_t* const hSocket = ctx;
+    size_t actualLen = 0;
+
+    switch (OS_Socket_write(*hSocket, buf, len, &actualLen))
+    {
+    case OS_SUCCESS:
+        return (int)actualLen;
+    case OS_ERROR_TRY_AGAIN:
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+    case OS_ERROR_NETWORK_CONN_SHUTDOWN:
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    default:
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+}
+
+static int
+recvCallback(
+    void*          ctx,
+    unsigned char* buf,
+    size_t         len)
+{
+    const OS_Socket_Handle_t* const hSocket = ctx;
+    size_t actualLen = 0;
+
+    switch (OS_Socket_read(*hSocket, buf, len, &actualLen))
+    {
+    case OS_SUCCESS:
+        return (int)actualLen;
+    case OS_ERROR_TRY_AGAIN:
+        return MBEDTLS_ERR_SSL_WANT_READ;
+    case OS_ERROR_CONNECTION_CLOSED:
+        return 0;
+    case OS_ERROR_NETWORK_CONN_SHUTDOWN:
+        return MBEDTLS_ERR_NET_CONN_RESET;
+    default:
+        return MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+}
+
+// The target has no wall clock, so the TLS library of the SDK does not check
+// the validity period of certificates. Do the same, as the test certificates
+// of this demo have expired.
+static int
+verifyCallback(
+    void*             ctx,
+    mbedtls_x509_crt* crt,
+    int               depth,
+    uint32_t*         flags)
+{
+    *flags &= ~((uint32_t)(MBEDTLS_X509_BADCERT_EXPIRED
+                           | MBEDTLS_X509_BADCERT_FUTURE));
+
+    return 0;
+}
+
+static OS_Error_t
+mapResult(
+    const int         ret,
+    const char* const func)
+{
+    switch (ret)
+    {
+    case MBEDTLS_ERR_SSL_WANT_READ:
+    case MBEDTLS_ERR_SSL_WANT_WRITE:
+        return OS_ERROR_WOULD_BLOCK;
+    case MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY:
+        return OS_ERROR_CONNECTION_CLOSED;
+    case MBEDTLS_ERR_NET_CONN_RESET:
+        return OS_ERROR_NETWORK_CONN_SHUTDOWN;
+    default:
+        Debug_LOG_ERROR("%s() failed, code -0x%04x", func, -ret);
+        return OS_ERROR_ABORTED;
+    }
+}
+
+static OS_Error_t
+parseCredentials(
+    OS_Tls_t* const              self,
+    const OS_Tls_Config_t* const cfg)
+{
+    const char* const caCerts    = cfg->library.crypto.caCerts;
+    const char* const ownCert    = cfg->library.crypto.ownCert;
+    const char* const privateKey = cfg->library.crypto.privateKey;
+    int ret;
+
+    // PEM data is only accepted with the terminating zero.
+    ret = mbedtls_x509_crt_parse(&self->caCerts,
+                                 (const unsigned char*)caCerts,
+                                 strlen(caCerts) + 1);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("Parsing CA certs failed, code -0x%04x", -ret);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    ret = mbedtls_x509_crt_parse(&self->ownCert,
+                                 (const unsigned char*)ownCert,
+                                 strlen(ownCert) + 1);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("Parsing own cert failed, code -0x%04x", -ret);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    ret = mbedtls_pk_parse_key(&self->privateKey,
+                               (const unsigned char*)privateKey,
+                               strlen(privateKey) + 1, NULL, 0);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("Parsing private key failed, code -0x%04x", -ret);
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    return OS_SUCCESS;
+}
+
+static OS_Error_t
+setupConfig(
+    OS_Tls_t* const              self,
+    const OS_Tls_Config_t* const cfg)
+{
+    size_t numSuites = 0;
+    int ret;
+
+    for (size_t i = 0; i < NUM_CIPHERSUITES; i++)
+    {
+        if (cfg->library.crypto.cipherSuites & cipherSuiteFlags[i].flag)
+        {
+            self->cipherSuites[numSuites++] = cipherSuiteFlags[i].suite;
+        }
+    }
+    if (0 == numSuites)
+    {
+        Debug_LOG_ERROR("No supported cipher suite configured");
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+    self->cipherSuites[numSuites] = 0;
+
+    ret = mbedtls_ssl_config_defaults(&self->conf,
+                                      MBEDTLS_SSL_IS_SERVER,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("mbedtls_ssl_config_defaults() failed, code -0x%04x",
+                        -ret);
+        return OS_ERROR_ABORTED;
+    }
+
+    mbedtls_ssl_conf_rng(&self->conf, HostCrypto_getRandom,
+                         cfg->library.crypto.handle);
+    mbedtls_ssl_conf_ciphersuites(&self->conf, self->cipherSuites);
+
+    // Like the TLS library of the SDK, only TLS 1.2 is offered.
+    mbedtls_ssl_conf_min_version(&self->conf, MBEDTLS_SSL_MAJOR_VERSION_3,
+                                 MBEDTLS_SSL_MINOR_VERSION_3);
+    mbedtls_ssl_conf_max_version(&self->conf, MBEDTLS_SSL_MAJOR_VERSION_3,
+                                 MBEDTLS_SSL_MINOR_VERSION_3);
+
+    // Clients have to authenticate with a certificate issued by the CA.
+    mbedtls_ssl_conf_authmode(&self->conf,
+                              (cfg->library.flags & OS_Tls_FLAG_NO_VERIFY) ?
+                              MBEDTLS_SSL_VERIFY_NONE :
+                              MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_ca_chain(&self->conf, &self->caCerts, NULL);
+    mbedtls_ssl_conf_verify(&self->conf, verifyCallback, NULL);
+
+    ret = mbedtls_ssl_conf_own_cert(&self->conf, &self->ownCert,
+                                    &self->privateKey);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("mbedtls_ssl_conf_own_cert() failed, code -0x%04x",
+                        -ret);
+        return OS_ERROR_ABORTED;
+    }
+
+    return OS_SUCCESS;
+}
+
+//------------------------------------------------------------------------------
+
+OS_Tls_CipherSuite_Flags_t
+OS_Tls_getCipherSuiteFlags(
+    const OS_Tls_CipherSuite_t* suites)
+{
+    OS_Tls_CipherSuite_Flags_t flags = 0;
+
+    for (; OS_Tls_CIPHERSUITE_NONE != *suites; suites++)
+    {
+        for (size_t i = 0; i < NUM_CIPHERSUITES; i++)
+        {
+            if (cipherSuiteFlags[i].suite == *suites)
+            {
+                flags |= cipherSuiteFlags[i].flag;
+            }
+        }
+    }
+
+    return flags;
+}
+
+OS_Error_t
+OS_Tls_init(
+    OS_Tls_Handle_t* const       self,
+    const OS_Tls_Config_t* const cfg)
+{
+    if ((NULL == self) || (NULL == cfg) || (NULL == cfg->library.socket.context)
+        || (NULL == cfg->library.crypto.handle)
+        || (NULL == cfg->library.crypto.caCerts)
+        || (NULL == cfg->library.crypto.ownCert)
+        || (NULL == cfg->library.crypto.privateKey))
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    OS_Tls_t* const tls = calloc(1, sizeof(*tls));
+    if (NULL == tls)
+    {
+        return OS_ERROR_INSUFFICIENT_SPACE;
+    }
+
+    mbedtls_ssl_init(&tls->ssl);
+    mbedtls_ssl_config_init(&tls->conf);
+    mbedtls_x509_crt_init(&tls->caCerts);
+    mbedtls_x509_crt_init(&tls->ownCert);
+    mbedtls_pk_init(&tls->privateKey);
+
+    OS_Error_t err = parseCredentials(tls, cfg);
+    if (OS_SUCCESS == err)
+    {
+        err = setupConfig(tls, cfg);
+    }
+    if (OS_SUCCESS == err)
+    {
+        const int ret = mbedtls_ssl_setup(&tls->ssl, &tls->conf);
+        if (0 != ret)
+        {
+            Debug_LOG_ERROR("mbedtls_ssl_setup() failed, code -0x%04x", -ret);
+            err = OS_ERROR_ABORTED;
+        }
+    }
+    if (OS_SUCCESS != err)
+    {
+        OS_Tls_free(tls);
+        return err;
+    }
+
+    mbedtls_ssl_set_bio(&tls->ssl, cfg->library.socket.context,
+                        sendCallback, recvCallback, NULL);
+
+    *self = tls;
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+OS_Tls_free(
+    OS_Tls_Handle_t self)
+{
+    if (NULL == self)
+    {
+        return OS_ERROR_INVALID_PARAMETER;
+    }
+
+    mbedtls_ssl_free(&self->ssl);
+    mbedtls_ssl_config_free(&self->conf);
+    mbedtls_pk_free(&self->privateKey);
+    mbedtls_x509_crt_free(&self->ownCert);
+    mbedtls_x509_crt_free(&self->caCerts);
+    free(self);
+
+    return OS_SUCCESS;
+}
+
+OS_Error_t
+OS_Tls_handshake(
+    OS_Tls_Handle_t self)
+{
+    const int ret = mbedtls_ssl_handshake(&self->ssl);
+
+    return (0 == ret) ? OS_SUCCESS : mapResult(ret, "mbedtls_ssl_handshake");
+}
+
+OS_Error_t
+OS_Tls_read(
+    OS_Tls_Handle_t self,
+    void* const     data,
+    size_t* const   dataSize)
+{
+    const int ret = mbedtls_ssl_read(&self->ssl, data, *dataSize);
+    if (ret > 0)
+    {
+        *dataSize = (size_t)ret;
+        return OS_SUCCESS;
+    }
+
+    *dataSize = 0;
+
+    return (0 == ret) ? OS_ERROR_CONNECTION_CLOSED :
+           mapResult(ret, "mbedtls_ssl_read");
+}
+
+OS_Error_t
+OS_Tls_write(
+    OS_Tls_Handle_t   self,
+    const void* const data,
+    size_t* const     dataSize)
+{
+    const int ret = mbedtls_ssl_write(&self->ssl, data, *dataSize);
+    if (ret >= 0)
+    {
+        *dataSize = (size_t)ret;
+        return OS_SUCCESS;
+    }
+
+    *dataSize = 0;
+
+    return mapResult(ret, "mbedtls_ssl_write");
+}
+
+OS_Error_t
+OS_Tls_reset(
+    OS_Tls_Handle_t self)
+{
+    const int ret = mbedtls_ssl_session_reset(&self->ssl);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("mbedtls_ssl_session_reset() failed, code -0x%04x",
+                        -ret);
+        return OS_ERROR_ABORTED;
+    }
+
+    return OS_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/*
+ * Test the event log with a consumer thread draining it concurrently
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "EventLog.h"
+#include "system_config.h"
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+
+#define NUM_RECORDS 1000000
+
+// Records added before the consumer starts, the ones beyond the size of the
+// ring buffer are lost.
+#define NUM_PREFILL (TLS_SERVER_EVENT_LOG_SIZE + 10)
+
+// Every record starts a new window of the rate limit, so none is dropped by
+// it and only a full ring buffer loses records.
+#define WINDOW_US   1000000
+
+#define EVENT       1
+
+// Derived from the sequence number, to detect torn records.
+#define CHECK_VALUE(_seq_)  ((uint32_t)(_seq_) ^ 0xa5a5a5a5)
+
+// State of the consumer.
+static uint64_t mNumFormatted = 0;
+static uint64_t mLastSeq = 0;
+static unsigned int mNumErrors = 0;
+
+static int mIsDone = 0;
+
+//------------------------------------------------------------------------------
+
+static void
+checkRecord(
+    const EventLog_Record_t* record)
+{
+    const uint64_t seq = record->arg1;
+
+    if (((0 != mNumFormatted) && (seq <= mLastSeq))
+        || (EVENT != record->event)
+        || (CHECK_VALUE(seq) != record->arg0)
+        || ((seq * WINDOW_US) != record->timeUs))
+    {
+        if (mNumErrors++ < 10)
+        {
+            printf("FAIL: record %" PRIu64 " after %" PRIu64 " is corrupt\n",
+                   seq, mLastSeq);
+        }
+    }
+
+    mLastSeq = seq;
+    mNumFormatted++;
+}
+
+static void*
+runConsumer(
+    void* ctx)
+{
+    while (!__atomic_load_n(&mIsDone, __ATOMIC_ACQUIRE))
+    {
+        EventLog_drain();
+    }
+
+    // Records added after the last drain above.
+    EventLog_drain();
+
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+
+int
+main(void)
+{
+    EventLog_init(checkRecord);
+
+    uint64_t numStored = 0;
+    uint64_t seq = 1;
+
+    for (; seq <= NUM_PREFILL; seq++)
+    {
+        if (EventLog_add(EVENT, 0, CHECK_VALUE(seq), seq, seq * WINDOW_US))
+        {
+            numStored++;
+        }
+    }
+
+    pthread_t consumer;
+    if (0 != pthread_create(&consumer, NULL, runConsumer, NULL))
+    {
+        printf("FAIL: cannot create the consumer thread\n");
+        return EXIT_FAILURE;
+    }
+
+    for (; seq <= NUM_RECORDS; seq++)
+    {
+        if (EventLog_add(EVENT, 0, CHECK_VALUE(seq), seq, seq * WINDOW_US))
+        {
+            numStored++;
+        }
+        else
+        {
+            // Let the consumer catch up, so records pass concurrently.
+            sched_yield();
+        }
+    }
+
+    __atomic_store_n(&mIsDone, 1, __ATOMIC_RELEASE);
+    pthread_join(consumer, NULL);
+
+    EventLog_Stats_t stats;
+    EventLog_getStats(&stats);
+
+    if (0 != mNumErrors)
+    {
+        printf("FAIL: %u corrupt records\n", mNumErrors);
+        return EXIT_FAILURE;
+    }
+
+    if ((mNumFormatted != numStored) || EventLog_hasRecords())
+    {
+        printf("FAIL: %" PRIu64 " records stored, %" PRIu64 " formatted\n",
+               numStored, mNumFormatted);
+        return EXIT_FAILURE;
+    }
+
+    // Reports of lost records are not counted as lost themselves.
+    if ((0 != stats.suppressed)
+        || ((numStored + stats.overflows) != NUM_RECORDS))
+    {
+        printf("FAIL: %" PRIu64 " records suppressed, %" PRIu64 " lost to "
+               "overflows\n", stats.suppressed, stats.overflows);
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS: %" PRIu64 " of %d records formatted, %" PRIu64 " lost to "
+           "overflows\n", mNumFormatted, NUM_RECORDS, stats.overflows);
+
+    return EXIT_SUCCESS;
+}
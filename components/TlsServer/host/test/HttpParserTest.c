@@ -0,0 +1,151 @@
+/*
+ * Test the HTTP request parser with valid and malformed requests
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "HttpParser.h"
+
+#include "lib_compiler/compiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+
+#define MAX_HEADER_SIZE 1024
+#define MAX_BODY_SIZE   1024
+
+// Requests are given with their size, as some contain a nul.
+#define REQUEST(_str_)  _str_, (sizeof(_str_) - 1)
+
+typedef struct
+{
+    const char*         name;
+    const char*         request;
+    size_t              size;
+    HttpParser_Result_t result;
+    unsigned int        status;
+    uint64_t            contentLength;
+}
+TestCase_t;
+
+static const TestCase_t mTestCases[] =
+{
+    {
+        "valid request",
+        REQUEST("GET / HTTP/1.1\r\nHost: a\r\n\r\n"),
+        HttpParser_RESULT_COMPLETE, 0, 0
+    },
+    {
+        "valid body length",
+        REQUEST("POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\n"),
+        HttpParser_RESULT_COMPLETE, 0, 5
+    },
+    {
+        "nul in method",
+        REQUEST("GE\0T / HTTP/1.1\r\n\r\n"),
+        HttpParser_RESULT_ERROR, 400, 0
+    },
+    {
+        "nul ending method",
+        REQUEST("GET\0 / HTTP/1.1\r\n\r\n"),
+        HttpParser_RESULT_ERROR, 400, 0
+    },
+    {
+        "nul in header name",
+        REQUEST("GET / HTTP/1.1\r\nHo\0st: a\r\n\r\n"),
+        HttpParser_RESULT_ERROR, 400, 0
+    },
+    {
+        "nul ending header name",
+        REQUEST("GET / HTTP/1.1\r\nContent-Length\0: 5\r\n\r\n"),
+        HttpParser_RESULT_ERROR, 400, 0
+    },
+    {
+        "differing body lengths",
+        REQUEST("POST / HTTP/1.1\r\nContent-Length: 5\r\n"
+                "Content-Length: 0\r\n\r\n"),
+        HttpParser_RESULT_ERROR, 400, 0
+    },
+    {
+        "repeated body length",
+        REQUEST("POST / HTTP/1.1\r\nContent-Length: 5\r\n"
+                "content-length: 5\r\n\r\n"),
+        HttpParser_RESULT_ERROR, 400, 0
+    },
+    {
+        "body length list",
+        REQUEST("POST / HTTP/1.1\r\nContent-Length: 5, 5\r\n\r\n"),
+        HttpParser_RESULT_ERROR, 400, 0
+    },
+    {
+        "body too large",
+        REQUEST("POST / HTTP/1.1\r\nContent-Length: 1025\r\n\r\n"),
+        HttpParser_RESULT_ERROR, 413, 0
+    },
+    {
+        "chunked body",
+        REQUEST("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"),
+        HttpParser_RESULT_ERROR, 501, 0
+    },
+};
+
+//------------------------------------------------------------------------------
+
+// Feed the request at once and byte by byte, which must give the same result.
+static bool
+runTestCase(
+    const TestCase_t* const test)
+{
+    for (size_t step = test->size; step > 0; step = (step > 1) ? 1 : 0)
+    {
+        HttpParser_t parser;
+        HttpParser_Result_t result = HttpParser_RESULT_INCOMPLETE;
+
+        HttpParser_init(&parser, MAX_HEADER_SIZE, MAX_BODY_SIZE);
+
+        for (size_t size = step;
+             (HttpParser_RESULT_INCOMPLETE == result) && (size <= test->size);
+             size += step)
+        {
+            result = HttpParser_parseHeader(&parser, test->request, size);
+        }
+
+        if ((result != test->result)
+            || ((HttpParser_RESULT_ERROR == result)
+                && (parser.status != test->status))
+            || ((HttpParser_RESULT_COMPLETE == result)
+                && (parser.contentLength != test->contentLength)))
+        {
+            printf("FAIL: %s (in steps of %zu): result %d, status %u\n",
+                   test->name, step, result, parser.status);
+            return false;
+        }
+    }
+
+    printf("PASS: %s\n", test->name);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+int
+main(void)
+{
+    size_t numFailed = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(mTestCases); i++)
+    {
+        if (!runTestCase(&mTestCases[i]))
+        {
+            numFailed++;
+        }
+    }
+
+    return (0 == numFailed) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,116 @@
+/*
+ * Test that the metrics page fits into TLS_SERVER_METRICS_PAGE_SIZE
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "Metrics.h"
+#include "system_config.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+//------------------------------------------------------------------------------
+
+// Widest decimal value of a uint64_t.
+#define MAX_DIGITS 20
+
+// Timeouts, rejections and the number of durations are raised one at a time,
+// so they stay at a single digit.
+#define MISSING_DIGITS \
+    ((Metrics_NUM_TIMEOUTS + Metrics_NUM_REJECTS + Metrics_NUM_PHASES) \
+     * (MAX_DIGITS - 1))
+
+static char mPage[TLS_SERVER_METRICS_PAGE_SIZE];
+
+//------------------------------------------------------------------------------
+
+static void
+setMaximumValues(void)
+{
+    for (unsigned int counter = 0; counter < Metrics_NUM_COUNTERS; counter++)
+    {
+        Metrics_addCount(counter, UINT64_MAX);
+    }
+
+    for (unsigned int phase = 0; phase < Metrics_NUM_PHASES; phase++)
+    {
+        Metrics_addDuration(phase, 0, UINT64_MAX);
+    }
+
+    for (unsigned int step = 0; step < Metrics_NUM_STARTUP_STEPS; step++)
+    {
+        Metrics_setStartupDuration(step, 0, UINT64_MAX);
+    }
+
+    for (unsigned int timeout = 0; timeout < Metrics_NUM_TIMEOUTS; timeout++)
+    {
+        Metrics_addTimeout(timeout);
+    }
+
+    for (unsigned int reason = 0; reason < Metrics_NUM_REJECTS; reason++)
+    {
+        Metrics_addRejection(reason);
+    }
+
+    // One code more than counted separately adds the line of other codes.
+    for (int i = 0; i <= Metrics_MAX_ERROR_CODES; i++)
+    {
+        Metrics_addHandshakeFailure(INT_MIN + i);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+int
+main(void)
+{
+    const Metrics_Gauges_t gauges =
+    {
+        .activeConnections = SIZE_MAX,
+        .maxConnections    = SIZE_MAX,
+        .heapHighWater     = UINT64_MAX,
+        .heapSize          = UINT64_MAX,
+        .logSuppressed     = UINT64_MAX,
+        .logOverflows      = UINT64_MAX,
+        .arenaAllocations  = UINT64_MAX,
+        .arenaFallbacks    = UINT64_MAX,
+        .arenaReleases     = UINT64_MAX,
+        .arenaHighWater    = UINT64_MAX,
+        .arenaSize         = UINT64_MAX,
+    };
+
+    setMaximumValues();
+
+    const size_t len = Metrics_render(mPage, sizeof(mPage), &gauges);
+    if (0 == len)
+    {
+        printf("FAIL: metrics page exceeds %zu bytes\n", sizeof(mPage));
+        return EXIT_FAILURE;
+    }
+
+    if ((len + MISSING_DIGITS) >= sizeof(mPage))
+    {
+        printf("FAIL: metrics page of %zu bytes leaves no room for %d digits "
+               "in %zu bytes\n", len, MISSING_DIGITS, sizeof(mPage));
+        return EXIT_FAILURE;
+    }
+
+    // The page is discarded if it does not fit, including its nul.
+    if ((0 != Metrics_render(mPage, len, &gauges))
+        || (len != Metrics_render(mPage, len + 1, &gauges)))
+    {
+        printf("FAIL: page of %zu bytes not discarded on overflow\n", len);
+        return EXIT_FAILURE;
+    }
+
+    printf("PASS: metrics page of %zu bytes fits into %zu bytes\n",
+           len + MISSING_DIGITS, sizeof(mPage));
+
+    return EXIT_SUCCESS;
+}
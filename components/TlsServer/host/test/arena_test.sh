@@ -0,0 +1,90 @@
+#!/bin/bash -eu
+
+#-------------------------------------------------------------------------------
+#
+# Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+# 
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+# Check that the arena of a connection slot is empty again once its TLS context
+# was reset, so it is released as a whole.
+#
+# Usage: arena_test.sh <server> <certs dir> <port> <connections>
+#-------------------------------------------------------------------------------
+
+SERVER=$1
+CERTS_DIR=$2
+PORT=$3
+CONNECTIONS=$4
+
+# The test runs on worker 0 of the host build.
+WORKER_ID=0
+
+SERVER_PID=""
+
+#-------------------------------------------------------------------------------
+function cleanup()
+{
+    if [ -n "${SERVER_PID}" ]; then
+        kill ${SERVER_PID} 2>/dev/null || true
+        wait ${SERVER_PID} 2>/dev/null || true
+    fi
+}
+
+#-------------------------------------------------------------------------------
+function fail()
+{
+    echo "FAIL: $1" >&2
+    exit 1
+}
+
+#-------------------------------------------------------------------------------
+function request()
+{
+    local PAGE=$1
+    curl -s -k --max-time 5 \
+        --cert "${CERTS_DIR}/client.crt" \
+        --key "${CERTS_DIR}/client.key" \
+        "https://127.0.0.1:${PORT}${PAGE}"
+}
+
+#-------------------------------------------------------------------------------
+function get_metric()
+{
+    local METRICS=$1
+    local NAME=$2
+    echo "${METRICS}" | awk -v name="${NAME}" '$1 == name { print $2 }'
+}
+
+#-------------------------------------------------------------------------------
+trap cleanup EXIT
+
+"${SERVER}" ${WORKER_ID} &
+SERVER_PID=$!
+
+for i in $(seq 50); do
+    if (exec 3<>/dev/tcp/127.0.0.1/${PORT}) 2>/dev/null; then
+        break
+    fi
+    sleep 0.1
+done
+
+# One connection after the other, so the same slots are reused and reset.
+for i in $(seq ${CONNECTIONS}); do
+    request / >/dev/null || fail "request ${i} failed"
+done
+
+METRICS=$(request /metrics)
+RELEASES=$(get_metric "${METRICS}" tls_server_arena_releases_total)
+PINNED=$(get_metric "${METRICS}" tls_server_arena_pinned_total)
+
+if [ "${PINNED}" != "0" ]; then
+    fail "${PINNED} resets left chunks in the arena"
+fi
+if [ -z "${RELEASES}" ] || [ "${RELEASES}" -eq 0 ]; then
+    fail "no arena released after ${CONNECTIONS} connections"
+fi
+
+echo "PASS: ${RELEASES} arenas released after ${CONNECTIONS} connections"
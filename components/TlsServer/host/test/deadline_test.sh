@@ -0,0 +1,99 @@
+#!/bin/bash -eu
+
+#-------------------------------------------------------------------------------
+#
+# Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+# 
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+# Check that handshakes which never start are closed at their deadline, even if
+# no socket sees another event, and that a new client is admitted afterwards.
+#
+# Usage: deadline_test.sh <server> <certs dir> <port> <handshake timeout ms>
+#          <max handshakes>
+#-------------------------------------------------------------------------------
+
+SERVER=$1
+CERTS_DIR=$2
+PORT=$3
+TIMEOUT_MS=$4
+MAX_HANDSHAKES=$5
+
+# The test runs on worker 0 of the host build.
+WORKER_ID=0
+
+SERVER_PID=""
+
+#-------------------------------------------------------------------------------
+function cleanup()
+{
+    if [ -n "${SERVER_PID}" ]; then
+        kill ${SERVER_PID} 2>/dev/null || true
+        wait ${SERVER_PID} 2>/dev/null || true
+    fi
+}
+
+#-------------------------------------------------------------------------------
+function fail()
+{
+    echo "FAIL: $1" >&2
+    exit 1
+}
+
+#-------------------------------------------------------------------------------
+function request()
+{
+    local PAGE=$1
+    curl -s -k --max-time 5 \
+        --cert "${CERTS_DIR}/client.crt" \
+        --key "${CERTS_DIR}/client.key" \
+        "https://127.0.0.1:${PORT}${PAGE}"
+}
+
+#-------------------------------------------------------------------------------
+trap cleanup EXIT
+
+"${SERVER}" ${WORKER_ID} &
+SERVER_PID=$!
+
+for i in $(seq 50); do
+    if (exec 3<>/dev/tcp/127.0.0.1/${PORT}) 2>/dev/null; then
+        break
+    fi
+    sleep 0.1
+done
+
+# Occupy all handshakes with connections that never send a ClientHello. The
+# probe above was closed right away and does not count.
+sleep 0.5
+for i in $(seq ${MAX_HANDSHAKES}); do
+    eval "exec $((i + 10))<>/dev/tcp/127.0.0.1/${PORT}"
+done
+START_MS=$(date +%s%3N)
+
+if request / >/dev/null; then
+    fail "client admitted while ${MAX_HANDSHAKES} handshakes are in progress"
+fi
+
+# Nothing happens on any socket until the deadline has passed.
+sleep $(( (TIMEOUT_MS + 1000) / 1000 ))
+
+if ! request / >/dev/null; then
+    fail "client not admitted $(( $(date +%s%3N) - START_MS )) ms after the \
+idle handshakes were opened"
+fi
+
+ELAPSED_MS=$(( $(date +%s%3N) - START_MS ))
+if [ ${ELAPSED_MS} -gt $(( TIMEOUT_MS + 5000 )) ]; then
+    fail "client admitted only after ${ELAPSED_MS} ms"
+fi
+
+TIMEOUTS=$(request /metrics \
+    | awk '/^tls_server_timeouts_total\{phase="handshake"\}/ { print $2 }')
+if [ "${TIMEOUTS}" != "${MAX_HANDSHAKES}" ]; then
+    fail "expected ${MAX_HANDSHAKES} handshake timeouts, got '${TIMEOUTS}'"
+fi
+
+echo "PASS: idle handshakes closed, client admitted after ${ELAPSED_MS} ms"
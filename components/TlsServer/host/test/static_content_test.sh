@@ -0,0 +1,53 @@
+#!/bin/bash -eu
+
+#-------------------------------------------------------------------------------
+#
+# Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+# 
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+# Check that the static content table compiles for an empty content directory
+# and for one with files, including an empty one.
+#
+# Usage: static_content_test.sh <C compiler> <TlsServer dir>
+#-------------------------------------------------------------------------------
+
+CC=$1
+TLS_SERVER_DIR=$2
+
+WORK_DIR=$(mktemp -d)
+trap "rm -rf ${WORK_DIR}" EXIT
+
+#-------------------------------------------------------------------------------
+function check_table()
+{
+    local NAME=$1
+    local CONTENT_DIR=$2
+
+    cmake -DCONTENT_DIR="${CONTENT_DIR}" \
+        -DOUTPUT_FILE="${WORK_DIR}/${NAME}.c" \
+        -P "${TLS_SERVER_DIR}/cmake/GenerateStaticContent.cmake"
+
+    # Compilers accept an empty initializer as extension, ISO C does not.
+    if ! "${CC}" -std=c99 -pedantic-errors -Wall -Werror -c \
+        -I "${TLS_SERVER_DIR}/include" \
+        -o "${WORK_DIR}/${NAME}.o" \
+        "${WORK_DIR}/${NAME}.c"; then
+        echo "FAIL: table of ${NAME} content directory does not compile" >&2
+        exit 1
+    fi
+
+    echo "PASS: table of ${NAME} content directory compiles"
+}
+
+#-------------------------------------------------------------------------------
+mkdir "${WORK_DIR}/empty"
+check_table empty "${WORK_DIR}/empty"
+
+mkdir -p "${WORK_DIR}/files/docs"
+echo "<html></html>" > "${WORK_DIR}/files/index.html"
+echo "text" > "${WORK_DIR}/files/docs/a.txt"
+touch "${WORK_DIR}/files/docs/empty.txt"
+check_table files "${WORK_DIR}/files"
@@ -0,0 +1,88 @@
+/*
+ * Per-connection arenas for the allocations of the TLS library
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// No arena selected, allocations go to the global heap.
+#define ConnectionArena_NONE SIZE_MAX
+
+typedef struct
+{
+    // Allocations served by an arena.
+    uint64_t allocations;
+    // Allocations that went to the global heap although an arena was
+    // selected, because they were too large or the arena was full.
+    uint64_t fallbacks;
+    // Arenas that were released completely as their last chunk was freed.
+    uint64_t releases;
+    // Largest part of an arena ever carved into chunks.
+    size_t   highWater;
+}
+ConnectionArena_Stats_t;
+
+/**
+ * Select the arena of a connection slot for the following allocations, or
+ * ConnectionArena_NONE.
+ */
+void
+ConnectionArena_select(
+    const size_t index);
+
+/**
+ * Allocate from the selected arena. Every arena of
+ * TLS_SERVER_CONNECTION_ARENA_SIZE bytes is carved into chunks of power-of-two
+ * size classes, freed chunks are kept on a free list per class.
+ *
+ * @return NULL if no arena is selected or the allocation does not fit, the
+ *  caller falls back to the global heap then
+ */
+void*
+ConnectionArena_alloc(
+    const size_t size);
+
+/**
+ * Return a chunk to the free list of its arena. Once all chunks of an arena
+ * are freed, as happens with its TLS context, the arena is released at once.
+ *
+ * @return false if the pointer does not belong to an arena
+ */
+bool
+ConnectionArena_free(
+    void* const ptr);
+
+/**
+ * @return true if no chunk of the arena of a connection slot is in use
+ */
+bool
+ConnectionArena_isEmpty(
+    const size_t index);
+
+/**
+ * @return number of times the arena of a connection slot was released
+ */
+uint64_t
+ConnectionArena_getReleases(
+    const size_t index);
+
+/**
+ * @return usable size of a chunk, 0 if the pointer does not belong to an
+ *  arena
+ */
+size_t
+ConnectionArena_getSize(
+    const void* const ptr);
+
+void
+ConnectionArena_getStats(
+    ConnectionArena_Stats_t* const stats);
@@ -0,0 +1,103 @@
+/*
+ * Binary event log, formatted outside of the request path
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Event ids must be below this limit, each one is rate limited on its own.
+#define EventLog_MAX_EVENTS 32
+
+// Connection of an event that does not belong to a connection slot.
+#define EventLog_NO_CONNECTION UINT16_MAX
+
+/**
+ * Compact record of an event, the meaning of the arguments depends on the
+ * event.
+ */
+typedef struct
+{
+    uint64_t timeUs;
+    uint16_t event;
+    uint16_t conn;
+    uint32_t arg0;
+    uint64_t arg1;
+}
+EventLog_Record_t;
+
+/**
+ * Format a record, called by EventLog_drain() for every record.
+ */
+typedef void (*EventLog_Format_t)(
+    const EventLog_Record_t* record);
+
+typedef struct
+{
+    uint64_t written;
+    // Records lost because the ring buffer was full.
+    uint64_t overflows;
+    // Records dropped by the rate limit.
+    uint64_t suppressed;
+}
+EventLog_Stats_t;
+
+/**
+ * Set the function that formats the records. Must be called before any other
+ * function of the event log.
+ */
+void
+EventLog_init(
+    EventLog_Format_t format);
+
+/**
+ * Append a record to the ring buffer of TLS_SERVER_EVENT_LOG_SIZE records, no
+ * formatting or output is done here. Every event is limited to
+ * TLS_SERVER_EVENT_LOG_RATE_LIMIT records per second, the number of records
+ * dropped by the limit is logged once the next second starts.
+ *
+ * Only a single producer may call this function.
+ *
+ * @return true if the record was stored, false if it was dropped
+ */
+bool
+EventLog_add(
+    const uint16_t event,
+    const uint16_t conn,
+    const uint32_t arg0,
+    const uint64_t arg1,
+    const uint64_t nowUs);
+
+/**
+ * Format and output all buffered records, as well as the number of records
+ * lost since the last call.
+ *
+ * Only a single consumer may call this function, it may run concurrently to
+ * the producer.
+ *
+ * @return number of records formatted
+ */
+size_t
+EventLog_drain(void);
+
+/**
+ * Check whether records are waiting to be drained, must be called by the
+ * producer.
+ */
+bool
+EventLog_hasRecords(void);
+
+/**
+ * Get the statistics of the producer, must be called by the producer.
+ */
+void
+EventLog_getStats(
+    EventLog_Stats_t* const stats);
@@ -0,0 +1,148 @@
+/*
+ * Incremental HTTP/1.x request parser
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Headers of a request that are remembered, further headers are rejected.
+#define HttpParser_MAX_HEADERS 24
+
+typedef enum
+{
+    HttpParser_RESULT_INCOMPLETE = 0,
+    HttpParser_RESULT_COMPLETE,
+    HttpParser_RESULT_ERROR
+}
+HttpParser_Result_t;
+
+/**
+ * Part of the receive buffer, the parser never copies request data. Offsets
+ * are relative to the start of the request.
+ */
+typedef struct
+{
+    size_t offset;
+    size_t len;
+}
+HttpParser_Span_t;
+
+typedef struct
+{
+    HttpParser_Span_t name;
+    HttpParser_Span_t value;
+}
+HttpParser_Header_t;
+
+typedef struct
+{
+    // Limits, see HttpParser_init().
+    size_t              maxHeaderSize;
+    uint64_t            maxBodySize;
+
+    // Scan state, allows to continue where the previous call stopped.
+    size_t              lineStart;
+    size_t              scanOffset;
+    bool                hasRequestLine;
+
+    // Request line.
+    HttpParser_Span_t   method;
+    HttpParser_Span_t   target;
+    unsigned int        versionMinor;
+
+    HttpParser_Header_t headers[HttpParser_MAX_HEADERS];
+    size_t              numHeaders;
+
+    // Size of request line and headers including the terminating empty line.
+    size_t              headerSize;
+    bool                keepAlive;
+    bool                hasContentLength;
+    uint64_t            contentLength;
+    uint64_t            bodyRemaining;
+
+    // HTTP status code to reply with if parsing failed.
+    unsigned int        status;
+}
+HttpParser_t;
+
+/**
+ * Prepare the parser for the next request.
+ *
+ * @param maxHeaderSize size of the buffer holding the request line and
+ *  headers, a longer header is rejected with 431
+ * @param maxBodySize largest accepted request body, a larger one is rejected
+ *  with 413
+ */
+void
+HttpParser_init(
+    HttpParser_t* const self,
+    const size_t        maxHeaderSize,
+    const uint64_t      maxBodySize);
+
+/**
+ * Parse the request line and headers.
+ *
+ * The buffer must contain everything received of the request so far, starting
+ * with its first byte. Only data that was not seen by a previous call is
+ * scanned, so it can be called whenever new data arrived.
+ *
+ * @return HttpParser_RESULT_INCOMPLETE if more data is needed,
+ *  HttpParser_RESULT_COMPLETE if the header is complete (see headerSize),
+ *  HttpParser_RESULT_ERROR if the request is invalid (see status)
+ */
+HttpParser_Result_t
+HttpParser_parseHeader(
+    HttpParser_t* const self,
+    const char* const   buf,
+    const size_t        size);
+
+/**
+ * Account for body data following the header, which may arrive in any number
+ * of chunks.
+ *
+ * @return number of the available bytes that belong to the body
+ */
+size_t
+HttpParser_consumeBody(
+    HttpParser_t* const self,
+    const size_t        available);
+
+/**
+ * Find a header by its (case insensitive) name.
+ *
+ * @return true if the header was found and value is set
+ */
+bool
+HttpParser_getHeader(
+    const HttpParser_t* const self,
+    const char* const         buf,
+    const char* const         name,
+    HttpParser_Span_t* const  value);
+
+/**
+ * Compare the method of the request with a string, case sensitive.
+ */
+bool
+HttpParser_isMethod(
+    const HttpParser_t* const self,
+    const char* const         buf,
+    const char* const         method);
+
+/**
+ * Compare a span of the request with a string, case insensitive as needed for
+ * header names and most header values.
+ */
+bool
+HttpParser_isEqual(
+    const char* const             buf,
+    const HttpParser_Span_t* const span,
+    const char* const             str);
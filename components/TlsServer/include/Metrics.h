@@ -0,0 +1,203 @@
+/*
+ * Latency histograms and counters of the TLS server
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include "OS_Error.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bucket i counts durations in [2^i, 2^(i+1)) microseconds, the first one
+// also counts zero.
+#define Metrics_NUM_BUCKETS 32
+
+// Distinct error codes of failed handshakes that are counted separately.
+#define Metrics_MAX_ERROR_CODES 8
+
+// Durations of a connection, each measured from the end of the previous one,
+// and of the single steps of the handshake.
+typedef enum
+{
+    Metrics_PHASE_ACCEPT = 0,       // accept until start of the handshake
+    Metrics_PHASE_HANDSHAKE,        // start until end of the handshake
+    Metrics_PHASE_FIRST_BYTE,       // end of the handshake until first data read
+    Metrics_PHASE_RESPONSE,         // complete request until response written
+    Metrics_PHASE_CONNECTION,       // accept until close
+    Metrics_PHASE_HANDSHAKE_STEP,   // one call of OS_Tls_handshake()
+    Metrics_NUM_PHASES
+}
+Metrics_Phase_t;
+
+// Steps of the startup in run(), measured once.
+typedef enum
+{
+    Metrics_STARTUP_NETWORK_STACK = 0,  // waiting for the NetworkStack
+    Metrics_STARTUP_CRYPTO,             // crypto library
+    Metrics_STARTUP_TLS_CONTEXTS,       // TLS context of every connection slot
+    Metrics_STARTUP_TOTAL,              // run() entry until listening
+    Metrics_NUM_STARTUP_STEPS
+}
+Metrics_StartupStep_t;
+
+// Deadlines of a connection, see TLS_SERVER_HANDSHAKE_TIMEOUT_MS and below.
+typedef enum
+{
+    Metrics_TIMEOUT_HANDSHAKE = 0,  // accept until end of the handshake
+    Metrics_TIMEOUT_FIRST_BYTE,     // end of the handshake until first data
+    Metrics_TIMEOUT_REQUEST,        // first data until complete request
+    Metrics_TIMEOUT_RESPONSE,       // response sent without progress
+    Metrics_TIMEOUT_KEEP_ALIVE,     // idle between requests
+    Metrics_NUM_TIMEOUTS
+}
+Metrics_Timeout_t;
+
+// Reasons to reject a connection right after accepting it.
+typedef enum
+{
+    Metrics_REJECT_FULL = 0,        // all connection slots busy
+    Metrics_REJECT_HANDSHAKES,      // too many handshakes in progress
+    Metrics_REJECT_PEER_LIMIT,      // too many connections of the client
+    Metrics_NUM_REJECTS
+}
+Metrics_Reject_t;
+
+typedef enum
+{
+    Metrics_COUNTER_CONNECTIONS = 0,
+    Metrics_COUNTER_HANDSHAKE_FAILURES,
+    Metrics_COUNTER_REQUESTS,
+    Metrics_COUNTER_WOULD_BLOCK,
+    Metrics_COUNTER_BYTES_IN,
+    Metrics_COUNTER_BYTES_OUT,
+    // Application data copied by the TLS Server itself, the copies inside the
+    // TLS library and the socket API are not seen.
+    Metrics_COUNTER_BYTES_COPIED,
+    // TLS contexts of closed connections reset while idle or on accept.
+    Metrics_COUNTER_TLS_RESETS_IDLE,
+    Metrics_COUNTER_TLS_RESETS_INLINE,
+    // Resets of a TLS context that left chunks in the arena of its slot.
+    Metrics_COUNTER_ARENAS_PINNED,
+    // Reads of the crypto library from the EntropySource, each one an RPC.
+    Metrics_COUNTER_ENTROPY_RPCS,
+    Metrics_COUNTER_ENTROPY_HANDSHAKE_RPCS,
+    Metrics_NUM_COUNTERS
+}
+Metrics_Counter_t;
+
+// State of the server at the time the metrics are rendered.
+typedef struct
+{
+    size_t   activeConnections;
+    size_t   maxConnections;
+    uint64_t heapHighWater;
+    uint64_t heapSize;
+    uint64_t logSuppressed;
+    uint64_t logOverflows;
+    uint64_t arenaAllocations;
+    uint64_t arenaFallbacks;
+    uint64_t arenaReleases;
+    uint64_t arenaHighWater;
+    uint64_t arenaSize;
+}
+Metrics_Gauges_t;
+
+typedef struct
+{
+    uint64_t count;
+    uint64_t sumUs;
+    uint64_t maxUs;
+    uint64_t buckets[Metrics_NUM_BUCKETS];
+}
+Metrics_Histogram_t;
+
+void
+Metrics_addDuration(
+    const Metrics_Phase_t phase,
+    const uint64_t        startUs,
+    const uint64_t        endUs);
+
+void
+Metrics_addCount(
+    const Metrics_Counter_t counter,
+    const uint64_t          value);
+
+/**
+ * Count a failed handshake, also by its error code.
+ */
+void
+Metrics_addHandshakeFailure(
+    const OS_Error_t err);
+
+void
+Metrics_setStartupDuration(
+    const Metrics_StartupStep_t step,
+    const uint64_t              startUs,
+    const uint64_t              endUs);
+
+/**
+ * Count a connection that was closed because it missed a deadline.
+ */
+void
+Metrics_addTimeout(
+    const Metrics_Timeout_t timeout);
+
+void
+Metrics_addRejection(
+    const Metrics_Reject_t reason);
+
+const char*
+Metrics_getRejectName(
+    const Metrics_Reject_t reason);
+
+const char*
+Metrics_getTimeoutName(
+    const Metrics_Timeout_t timeout);
+
+uint64_t
+Metrics_getCount(
+    const Metrics_Counter_t counter);
+
+const Metrics_Histogram_t*
+Metrics_getHistogram(
+    const Metrics_Phase_t phase);
+
+/**
+ * Estimate a percentile from the buckets of a histogram.
+ *
+ * @return upper bound of the bucket holding the percentile, limited to the
+ *  maximum duration seen, or 0 if the histogram is empty
+ */
+uint64_t
+Metrics_getPercentileUs(
+    const Metrics_Histogram_t* const histogram,
+    const unsigned int               percent);
+
+const char*
+Metrics_getPhaseName(
+    const Metrics_Phase_t phase);
+
+/**
+ * Log all counters and the percentiles of every phase.
+ */
+void
+Metrics_logSummary(void);
+
+/**
+ * Render all metrics in the Prometheus text format.
+ *
+ * @return length of the page, without terminating nul, or 0 if the page does
+ *  not fit into the buffer
+ */
+size_t
+Metrics_render(
+    char* const                   buf,
+    const size_t                  size,
+    const Metrics_Gauges_t* const gauges);
@@ -0,0 +1,64 @@
+/*
+ * Static content served by the TLS Server
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * A file with precomputed responses, the table of entries is generated at
+ * build time from the content directory (see GenerateStaticContent.cmake) and
+ * lives in read-only memory.
+ */
+typedef struct
+{
+    const char*    path;
+    size_t         pathLen;
+    // Entity tag including the quotes.
+    const char*    etag;
+    size_t         etagLen;
+    const uint8_t* body;
+    size_t         bodyLen;
+    // Response headers for "200 OK" and "304 Not Modified", the index selects
+    // "Connection: close" (0) or "Connection: keep-alive" (1). The keep-alive
+    // header of "200 OK" directly precedes the body in memory.
+    const char*    header[2];
+    size_t         headerLen[2];
+    const char*    notModified[2];
+    size_t         notModifiedLen[2];
+}
+StaticContent_Entry_t;
+
+// Sorted by path.
+extern const StaticContent_Entry_t StaticContent_entries[];
+extern const size_t StaticContent_numEntries;
+
+/**
+ * Look up the entry for a request path, a query string is ignored.
+ *
+ * @return entry or NULL if there is no content for the path
+ */
+const StaticContent_Entry_t*
+StaticContent_find(
+    const char* const path,
+    const size_t      pathLen);
+
+/**
+ * Check the value of an If-None-Match header against the entity tag.
+ *
+ * @return true if the client has the current version of the entry
+ */
+bool
+StaticContent_isNotModified(
+    const StaticContent_Entry_t* const entry,
+    const char* const                  ifNoneMatch,
+    const size_t                       ifNoneMatchLen);
@@ -0,0 +1,64 @@
+/*
+ * Hashed timer wheel for the deadlines of connections
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Timer embedded in the object it belongs to, the wheel never allocates.
+ */
+typedef struct TimerWheel_Timer
+{
+    struct TimerWheel_Timer*  next;
+    // Link pointing to this timer, NULL if the timer is not armed.
+    struct TimerWheel_Timer** pprev;
+    uint64_t                  expiryTick;
+    // Owner of the timer, not used by the wheel.
+    void*                     context;
+}
+TimerWheel_Timer_t;
+
+/**
+ * Start the wheel at the current time, which is given by the TimeServer.
+ */
+void
+TimerWheel_init(
+    const uint64_t nowMs);
+
+/**
+ * Arm a timer to expire at the given time, re-arming an armed timer moves it.
+ *
+ * The wheel has TLS_SERVER_TIMER_WHEEL_SIZE slots of TLS_SERVER_TIMER_TICK_MS,
+ * so arming and cancelling take constant time. Deadlines beyond one turn of
+ * the wheel stay in their slot for further turns.
+ */
+void
+TimerWheel_arm(
+    TimerWheel_Timer_t* const timer,
+    const uint64_t            deadlineMs);
+
+void
+TimerWheel_cancel(
+    TimerWheel_Timer_t* const timer);
+
+bool
+TimerWheel_isEmpty(void);
+
+/**
+ * Advance the wheel to the current time and take the next expired timer off
+ * the wheel. Timers expire up to one tick after their deadline.
+ *
+ * @return expired timer or NULL if there is none (left)
+ */
+TimerWheel_Timer_t*
+TimerWheel_expire(
+    const uint64_t nowMs);
@@ -0,0 +1,96 @@
+/*
+ * Heap functions of the component, linked with --wrap so the allocations of
+ * the TLS library go to the arena of the connection being processed
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "ConnectionArena.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+void  __real_free(void* ptr);
+
+void  __wrap_free(void* ptr);
+
+//------------------------------------------------------------------------------
+
+void*
+__wrap_malloc(
+    size_t size)
+{
+    void* const ptr = ConnectionArena_alloc(size);
+
+    return (NULL != ptr) ? ptr : __real_malloc(size);
+}
+
+void*
+__wrap_calloc(
+    size_t nmemb,
+    size_t size)
+{
+    if ((0 != size) && (nmemb > (SIZE_MAX / size)))
+    {
+        return NULL;
+    }
+
+    void* const ptr = ConnectionArena_alloc(nmemb * size);
+    if (NULL == ptr)
+    {
+        return __real_calloc(nmemb, size);
+    }
+
+    memset(ptr, 0, nmemb * size);
+
+    return ptr;
+}
+
+void*
+__wrap_realloc(
+    void*  ptr,
+    size_t size)
+{
+    const size_t oldSize = ConnectionArena_getSize(ptr);
+    if (0 == oldSize)
+    {
+        return __real_realloc(ptr, size);
+    }
+    if (0 == size)
+    {
+        __wrap_free(ptr);
+        return NULL;
+    }
+    if (size <= oldSize)
+    {
+        return ptr;
+    }
+
+    void* const newPtr = __wrap_malloc(size);
+    if (NULL != newPtr)
+    {
+        memcpy(newPtr, ptr, oldSize);
+        ConnectionArena_free(ptr);
+    }
+
+    return newPtr;
+}
+
+void
+__wrap_free(
+    void* ptr)
+{
+    if (!ConnectionArena_free(ptr))
+    {
+        __real_free(ptr);
+    }
+}
@@ -0,0 +1,195 @@
+/*
+ * Per-connection arenas for the allocations of the TLS library
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "ConnectionArena.h"
+#include "system_config.h"
+
+#include "lib_compiler/compiler.h"
+
+//------------------------------------------------------------------------------
+
+// Chunks start with a header holding their size class, which also keeps the
+// payload aligned like the one of malloc().
+#define CHUNK_HEADER_SIZE 16
+
+// Size classes from 32 to 4096 bytes including the header.
+#define MIN_CLASS_SHIFT 5
+#define NUM_CLASSES     8
+
+#define CLASS_SIZE(_class_) ((size_t)1 << ((_class_) + MIN_CLASS_SHIFT))
+
+//------------------------------------------------------------------------------
+
+typedef struct Chunk
+{
+    // Valid while the chunk is on a free list.
+    struct Chunk* next;
+}
+Chunk_t;
+
+typedef struct
+{
+    size_t   offset;
+    size_t   numChunks;
+    Chunk_t* freeLists[NUM_CLASSES];
+    // Kept when the arena is released.
+    uint64_t releases;
+}
+Arena_t;
+
+static uint8_t
+mMemory[TLS_SERVER_MAX_CONNECTIONS][TLS_SERVER_CONNECTION_ARENA_SIZE]
+__attribute__((aligned(CHUNK_HEADER_SIZE)));
+
+static Arena_t mArenas[TLS_SERVER_MAX_CONNECTIONS];
+static size_t mSelected = ConnectionArena_NONE;
+
+static ConnectionArena_Stats_t mStats;
+
+//------------------------------------------------------------------------------
+
+static bool
+isArenaPointer(
+    const void* const ptr)
+{
+    return ((const uint8_t*)ptr >= &mMemory[0][0])
+           && ((const uint8_t*)ptr < (&mMemory[0][0] + sizeof(mMemory)));
+}
+
+static inline uint8_t*
+getHeader(
+    const void* const ptr)
+{
+    return (uint8_t*)ptr - CHUNK_HEADER_SIZE;
+}
+
+//------------------------------------------------------------------------------
+
+void
+ConnectionArena_select(
+    const size_t index)
+{
+    mSelected = (index < ARRAY_SIZE(mArenas)) ? index : ConnectionArena_NONE;
+}
+
+void*
+ConnectionArena_alloc(
+    const size_t size)
+{
+    if (ConnectionArena_NONE == mSelected)
+    {
+        return NULL;
+    }
+
+    size_t class = 0;
+    while ((class < NUM_CLASSES)
+           && ((size + CHUNK_HEADER_SIZE) > CLASS_SIZE(class)))
+    {
+        class++;
+    }
+    if (NUM_CLASSES == class)
+    {
+        mStats.fallbacks++;
+        return NULL;
+    }
+
+    Arena_t* const arena = &mArenas[mSelected];
+    uint8_t* chunk = (uint8_t*)arena->freeLists[class];
+
+    if (NULL != chunk)
+    {
+        arena->freeLists[class] = ((Chunk_t*)chunk)->next;
+    }
+    else
+    {
+        if ((arena->offset + CLASS_SIZE(class)) > sizeof(mMemory[0]))
+        {
+            mStats.fallbacks++;
+            return NULL;
+        }
+
+        chunk = &mMemory[mSelected][arena->offset];
+        arena->offset += CLASS_SIZE(class);
+
+        if (arena->offset > mStats.highWater)
+        {
+            mStats.highWater = arena->offset;
+        }
+    }
+
+    chunk[0] = (uint8_t)class;
+    arena->numChunks++;
+    mStats.allocations++;
+
+    return chunk + CHUNK_HEADER_SIZE;
+}
+
+bool
+ConnectionArena_free(
+    void* const ptr)
+{
+    if (!isArenaPointer(ptr))
+    {
+        return false;
+    }
+
+    uint8_t* const chunk = getHeader(ptr);
+    const size_t index = (size_t)(chunk - &mMemory[0][0]) / sizeof(mMemory[0]);
+    Arena_t* const arena = &mArenas[index];
+
+    // Chunks are never split or merged, so an arena does not fragment.
+    if (0 == --arena->numChunks)
+    {
+        *arena = (Arena_t) { .releases = arena->releases + 1 };
+        mStats.releases++;
+        return true;
+    }
+
+    Chunk_t* const freeChunk = (Chunk_t*)chunk;
+    const size_t class = chunk[0];
+
+    freeChunk->next = arena->freeLists[class];
+    arena->freeLists[class] = freeChunk;
+
+    return true;
+}
+
+bool
+ConnectionArena_isEmpty(
+    const size_t index)
+{
+    return (0 == mArenas[index].numChunks);
+}
+
+uint64_t
+ConnectionArena_getReleases(
+    const size_t index)
+{
+    return mArenas[index].releases;
+}
+
+size_t
+ConnectionArena_getSize(
+    const void* const ptr)
+{
+    if (!isArenaPointer(ptr))
+    {
+        return 0;
+    }
+
+    return CLASS_SIZE(getHeader(ptr)[0]) - CHUNK_HEADER_SIZE;
+}
+
+void
+ConnectionArena_getStats(
+    ConnectionArena_Stats_t* const stats)
+{
+    *stats = mStats;
+}
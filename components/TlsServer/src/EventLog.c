@@ -0,0 +1,204 @@
+/*
+ * Binary event log, formatted outside of the request path
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "EventLog.h"
+#include "system_config.h"
+
+#include "lib_debug/Debug.h"
+#include <inttypes.h>
+
+//------------------------------------------------------------------------------
+
+#if (TLS_SERVER_EVENT_LOG_SIZE & (TLS_SERVER_EVENT_LOG_SIZE - 1)) != 0
+#error "TLS_SERVER_EVENT_LOG_SIZE must be a power of two"
+#endif
+
+#define RING_INDEX_MASK (TLS_SERVER_EVENT_LOG_SIZE - 1)
+
+// Window of the rate limit and minimum interval of the reports of lost
+// records.
+#define WINDOW_US 1000000
+
+// Reserved event of the record that reports lost records, arg0 holds the
+// number of suppressed and arg1 the number of overflowed records.
+#define EVENT_LOST UINT16_MAX
+
+//------------------------------------------------------------------------------
+
+typedef struct
+{
+    uint64_t windowStartUs;
+    uint32_t count;
+}
+RateLimit_t;
+
+static EventLog_Format_t mFormat;
+
+// The producer only writes mHead and the consumer only writes mTail, so the
+// ring buffer works without locks. Both indices count up and wrap around.
+static EventLog_Record_t mRing[TLS_SERVER_EVENT_LOG_SIZE];
+static size_t mHead = 0;
+static size_t mTail = 0;
+
+// State of the producer.
+static RateLimit_t mRateLimits[EventLog_MAX_EVENTS];
+static EventLog_Stats_t mStats;
+static uint64_t mReportUs = 0;
+static uint64_t mReportedSuppressed = 0;
+static uint64_t mReportedOverflows = 0;
+
+//------------------------------------------------------------------------------
+
+static bool
+push(
+    const EventLog_Record_t* const record)
+{
+    const size_t head = mHead;
+    const size_t tail = __atomic_load_n(&mTail, __ATOMIC_ACQUIRE);
+
+    if ((head - tail) >= TLS_SERVER_EVENT_LOG_SIZE)
+    {
+        return false;
+    }
+
+    mRing[head & RING_INDEX_MASK] = *record;
+
+    // Publish the record only after it is complete.
+    __atomic_store_n(&mHead, head + 1, __ATOMIC_RELEASE);
+    mStats.written++;
+
+    return true;
+}
+
+// Report lost records at most once per window, so a flood of events cannot
+// flood the log with reports either.
+static void
+reportLostRecords(
+    const uint64_t nowUs)
+{
+    if (((nowUs - mReportUs) < WINDOW_US)
+        || ((mStats.suppressed == mReportedSuppressed)
+            && (mStats.overflows == mReportedOverflows)))
+    {
+        return;
+    }
+
+    const EventLog_Record_t record =
+    {
+        .timeUs = nowUs,
+        .event  = EVENT_LOST,
+        .arg0   = (uint32_t)(mStats.suppressed - mReportedSuppressed),
+        .arg1   = mStats.overflows - mReportedOverflows
+    };
+
+    // If the ring buffer is still full, the numbers are reported later. The
+    // report itself is not counted as lost then, it is retried.
+    if (push(&record))
+    {
+        mReportUs = nowUs;
+        mReportedSuppressed = mStats.suppressed;
+        mReportedOverflows = mStats.overflows;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+EventLog_init(
+    EventLog_Format_t format)
+{
+    mFormat = format;
+}
+
+bool
+EventLog_add(
+    const uint16_t event,
+    const uint16_t conn,
+    const uint32_t arg0,
+    const uint64_t arg1,
+    const uint64_t nowUs)
+{
+    Debug_ASSERT(event < EventLog_MAX_EVENTS);
+
+    reportLostRecords(nowUs);
+
+    RateLimit_t* const limit = &mRateLimits[event];
+
+    if ((nowUs - limit->windowStartUs) >= WINDOW_US)
+    {
+        limit->windowStartUs = nowUs;
+        limit->count = 0;
+    }
+    if (limit->count >= TLS_SERVER_EVENT_LOG_RATE_LIMIT)
+    {
+        mStats.suppressed++;
+        return false;
+    }
+    limit->count++;
+
+    const EventLog_Record_t record =
+    {
+        .timeUs = nowUs,
+        .event  = event,
+        .conn   = conn,
+        .arg0   = arg0,
+        .arg1   = arg1
+    };
+
+    if (!push(&record))
+    {
+        mStats.overflows++;
+        return false;
+    }
+
+    return true;
+}
+
+size_t
+EventLog_drain(void)
+{
+    const size_t head = __atomic_load_n(&mHead, __ATOMIC_ACQUIRE);
+    size_t tail = mTail;
+    size_t numRecords = 0;
+
+    for (; tail != head; tail++, numRecords++)
+    {
+        const EventLog_Record_t* const record = &mRing[tail & RING_INDEX_MASK];
+
+        if (EVENT_LOST == record->event)
+        {
+            Debug_LOG_WARNING("Event log lost %" PRIu32 " records to the rate "
+                              "limit and %" PRIu64 " to overflows",
+                              record->arg0, record->arg1);
+        }
+        else
+        {
+            mFormat(record);
+        }
+
+        // Hand the slot back right away, the producer may run concurrently.
+        __atomic_store_n(&mTail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    return numRecords;
+}
+
+bool
+EventLog_hasRecords(void)
+{
+    return (mHead != __atomic_load_n(&mTail, __ATOMIC_ACQUIRE));
+}
+
+void
+EventLog_getStats(
+    EventLog_Stats_t* const stats)
+{
+    *stats = mStats;
+}
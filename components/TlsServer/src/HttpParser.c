@@ -0,0 +1,371 @@
+/*
+ * Incremental HTTP/1.x request parser
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "HttpParser.h"
+
+#include <string.h>
+#include <strings.h>
+
+//------------------------------------------------------------------------------
+
+static HttpParser_Result_t
+setError(
+    HttpParser_t* const self,
+    const unsigned int  status)
+{
+    self->status = status;
+    return HttpParser_RESULT_ERROR;
+}
+
+static bool
+isTokenChar(
+    const char c)
+{
+    // RFC 7230, 3.2.6, strchr() would also find the terminating nul.
+    return ((c >= '0') && (c <= '9'))
+           || ((c >= 'a') && (c <= 'z'))
+           || ((c >= 'A') && (c <= 'Z'))
+           || (('\0' != c) && (NULL != strchr("!#$%&'*+-.^_`|~", c)));
+}
+
+// Returns true if a comma separated header value contains the given token.
+static bool
+hasToken(
+    const char*       value,
+    const size_t      valueLen,
+    const char* const token)
+{
+    const size_t tokenLen = strlen(token);
+    const char* const end = value + valueLen;
+
+    while (value < end)
+    {
+        while ((value < end)
+               && ((*value == ' ') || (*value == '\t') || (*value == ',')))
+        {
+            value++;
+        }
+
+        const char* tokenEnd = value;
+        while ((tokenEnd < end) && (*tokenEnd != ',') && (*tokenEnd != ' ')
+               && (*tokenEnd != '\t'))
+        {
+            tokenEnd++;
+        }
+
+        if (((size_t)(tokenEnd - value) == tokenLen)
+            && (0 == strncasecmp(value, token, tokenLen)))
+        {
+            return true;
+        }
+
+        value = tokenEnd;
+    }
+
+    return false;
+}
+
+static HttpParser_Result_t
+parseRequestLine(
+    HttpParser_t* const self,
+    const char* const   buf,
+    const size_t        start,
+    const size_t        end)
+{
+    const char* const line = buf + start;
+    const size_t len = end - start;
+
+    // method SP request-target SP HTTP-version
+    size_t pos = 0;
+    while ((pos < len) && isTokenChar(line[pos]))
+    {
+        pos++;
+    }
+    if ((0 == pos) || (pos == len) || (line[pos] != ' '))
+    {
+        return setError(self, 400);
+    }
+    self->method.offset = start;
+    self->method.len = pos;
+
+    const size_t targetStart = ++pos;
+    while ((pos < len) && (line[pos] != ' '))
+    {
+        pos++;
+    }
+    if ((targetStart == pos) || (pos == len))
+    {
+        return setError(self, 400);
+    }
+    self->target.offset = start + targetStart;
+    self->target.len = pos - targetStart;
+
+    const char* const version = line + pos + 1;
+    const size_t versionLen = len - pos - 1;
+    if ((versionLen != 8) || (0 != strncmp(version, "HTTP/", 5))
+        || (version[6] != '.')
+        || (version[5] < '0') || (version[5] > '9')
+        || (version[7] < '0') || (version[7] > '9'))
+    {
+        return setError(self, 400);
+    }
+    if (version[5] != '1')
+    {
+        return setError(self, 505);
+    }
+
+    self->versionMinor = (unsigned int)(version[7] - '0');
+
+    // Persistent connections are the default since HTTP/1.1.
+    self->keepAlive = (self->versionMinor >= 1);
+    self->hasRequestLine = true;
+
+    return HttpParser_RESULT_INCOMPLETE;
+}
+
+static HttpParser_Result_t
+parseHeaderLine(
+    HttpParser_t* const self,
+    const char* const   buf,
+    const size_t        start,
+    const size_t        end)
+{
+    const char* const line = buf + start;
+    const size_t len = end - start;
+
+    size_t nameLen = 0;
+    while ((nameLen < len) && isTokenChar(line[nameLen]))
+    {
+        nameLen++;
+    }
+    // No whitespace is allowed between the name and the colon, obsolete line
+    // folding is rejected as well (RFC 7230, 3.2.4).
+    if ((0 == nameLen) || (nameLen == len) || (line[nameLen] != ':'))
+    {
+        return setError(self, 400);
+    }
+
+    size_t valueStart = nameLen + 1;
+    size_t valueEnd = len;
+    while ((valueStart < valueEnd)
+           && ((line[valueStart] == ' ') || (line[valueStart] == '\t')))
+    {
+        valueStart++;
+    }
+    while ((valueEnd > valueStart)
+           && ((line[valueEnd - 1] == ' ') || (line[valueEnd - 1] == '\t')))
+    {
+        valueEnd--;
+    }
+
+    if (self->numHeaders >= HttpParser_MAX_HEADERS)
+    {
+        return setError(self, 431);
+    }
+
+    HttpParser_Header_t* const header = &self->headers[self->numHeaders++];
+    header->name.offset = start;
+    header->name.len = nameLen;
+    header->value.offset = start + valueStart;
+    header->value.len = valueEnd - valueStart;
+
+    const char* const value = buf + header->value.offset;
+
+    if (HttpParser_isEqual(buf, &header->name, "Connection"))
+    {
+        if (hasToken(value, header->value.len, "close"))
+        {
+            self->keepAlive = false;
+        }
+        else if (hasToken(value, header->value.len, "keep-alive"))
+        {
+            self->keepAlive = true;
+        }
+    }
+    else if (HttpParser_isEqual(buf, &header->name, "Content-Length"))
+    {
+        uint64_t contentLength = 0;
+
+        // Another hop may pick a different one of several lengths and see
+        // a different request (RFC 7230, 3.3.2), so no duplicate is accepted.
+        if (self->hasContentLength || (0 == header->value.len))
+        {
+            return setError(self, 400);
+        }
+        for (size_t i = 0; i < header->value.len; i++)
+        {
+            if ((value[i] < '0') || (value[i] > '9'))
+            {
+                return setError(self, 400);
+            }
+            // Anything with more than 18 digits is too large in any case.
+            if (i >= 18)
+            {
+                return setError(self, 413);
+            }
+            contentLength = (contentLength * 10) + (uint64_t)(value[i] - '0');
+        }
+
+        if (contentLength > self->maxBodySize)
+        {
+            return setError(self, 413);
+        }
+
+        self->contentLength = contentLength;
+        self->hasContentLength = true;
+    }
+    else if (HttpParser_isEqual(buf, &header->name, "Transfer-Encoding"))
+    {
+        // Chunked bodies are not supported (RFC 7230, 3.3.1).
+        return setError(self, 501);
+    }
+
+    return HttpParser_RESULT_INCOMPLETE;
+}
+
+//------------------------------------------------------------------------------
+
+void
+HttpParser_init(
+    HttpParser_t* const self,
+    const size_t        maxHeaderSize,
+    const uint64_t      maxBodySize)
+{
+    memset(self, 0, sizeof(*self));
+
+    self->maxHeaderSize = maxHeaderSize;
+    self->maxBodySize = maxBodySize;
+}
+
+HttpParser_Result_t
+HttpParser_parseHeader(
+    HttpParser_t* const self,
+    const char* const   buf,
+    const size_t        size)
+{
+    if (self->status != 0)
+    {
+        return HttpParser_RESULT_ERROR;
+    }
+    if (self->headerSize != 0)
+    {
+        return HttpParser_RESULT_COMPLETE;
+    }
+
+    while (self->scanOffset < size)
+    {
+        const char* const lf = memchr(buf + self->scanOffset, '\n',
+                                      size - self->scanOffset);
+        if (NULL == lf)
+        {
+            self->scanOffset = size;
+            break;
+        }
+
+        const size_t next = (size_t)(lf - buf) + 1;
+        size_t lineEnd = next - 1;
+
+        // Accept a bare LF as line terminator as well (RFC 7230, 3.5).
+        if ((lineEnd > self->lineStart) && (buf[lineEnd - 1] == '\r'))
+        {
+            lineEnd--;
+        }
+
+        HttpParser_Result_t result = HttpParser_RESULT_INCOMPLETE;
+
+        if (!self->hasRequestLine)
+        {
+            // Empty lines before the request line are ignored (RFC 7230,
+            // 3.5).
+            if (lineEnd > self->lineStart)
+            {
+                result = parseRequestLine(self, buf, self->lineStart, lineEnd);
+            }
+        }
+        else if (lineEnd == self->lineStart)
+        {
+            self->headerSize = next;
+            self->bodyRemaining = self->contentLength;
+            return HttpParser_RESULT_COMPLETE;
+        }
+        else
+        {
+            result = parseHeaderLine(self, buf, self->lineStart, lineEnd);
+        }
+
+        if (HttpParser_RESULT_ERROR == result)
+        {
+            return result;
+        }
+
+        self->lineStart = next;
+        self->scanOffset = next;
+    }
+
+    if (size >= self->maxHeaderSize)
+    {
+        return setError(self, 431);
+    }
+
+    return HttpParser_RESULT_INCOMPLETE;
+}
+
+size_t
+HttpParser_consumeBody(
+    HttpParser_t* const self,
+    const size_t        available)
+{
+    const size_t size = (self->bodyRemaining < available) ?
+                        (size_t)self->bodyRemaining : available;
+
+    self->bodyRemaining -= size;
+
+    return size;
+}
+
+bool
+HttpParser_getHeader(
+    const HttpParser_t* const self,
+    const char* const         buf,
+    const char* const         name,
+    HttpParser_Span_t* const  value)
+{
+    for (size_t i = 0; i < self->numHeaders; i++)
+    {
+        if (HttpParser_isEqual(buf, &self->headers[i].name, name))
+        {
+            *value = self->headers[i].value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool
+HttpParser_isMethod(
+    const HttpParser_t* const self,
+    const char* const         buf,
+    const char* const         method)
+{
+    return (strlen(method) == self->method.len)
+           && (0 == memcmp(buf + self->method.offset, method,
+                           self->method.len));
+}
+
+bool
+HttpParser_isEqual(
+    const char* const             buf,
+    const HttpParser_Span_t* const span,
+    const char* const             str)
+{
+    return (strlen(str) == span->len)
+           && (0 == strncasecmp(buf + span->offset, str, span->len));
+}
@@ -0,0 +1,551 @@
+/*
+ * Latency histograms and counters of the TLS server
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "Metrics.h"
+
+#include "lib_compiler/compiler.h"
+#include "lib_debug/Debug.h"
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+//------------------------------------------------------------------------------
+
+static Metrics_Histogram_t mHistograms[Metrics_NUM_PHASES];
+static uint64_t mCounters[Metrics_NUM_COUNTERS];
+static uint64_t mStartupUs[Metrics_NUM_STARTUP_STEPS];
+static uint64_t mTimeouts[Metrics_NUM_TIMEOUTS];
+static uint64_t mRejections[Metrics_NUM_REJECTS];
+
+static struct
+{
+    OS_Error_t code;
+    uint64_t   count;
+}
+mHandshakeErrors[Metrics_MAX_ERROR_CODES];
+static size_t mNumHandshakeErrors = 0;
+
+static const char* const mPhaseNames[Metrics_NUM_PHASES] =
+{
+    [Metrics_PHASE_ACCEPT]         = "accept",
+    [Metrics_PHASE_HANDSHAKE]      = "handshake",
+    [Metrics_PHASE_FIRST_BYTE]     = "first_byte",
+    [Metrics_PHASE_RESPONSE]       = "response",
+    [Metrics_PHASE_CONNECTION]     = "connection",
+    [Metrics_PHASE_HANDSHAKE_STEP] = "handshake_step",
+};
+
+static const char* const mTimeoutNames[Metrics_NUM_TIMEOUTS] =
+{
+    [Metrics_TIMEOUT_HANDSHAKE]  = "handshake",
+    [Metrics_TIMEOUT_FIRST_BYTE] = "first_byte",
+    [Metrics_TIMEOUT_REQUEST]    = "request",
+    [Metrics_TIMEOUT_RESPONSE]   = "response",
+    [Metrics_TIMEOUT_KEEP_ALIVE] = "keep_alive",
+};
+
+static const char* const mRejectNames[Metrics_NUM_REJECTS] =
+{
+    [Metrics_REJECT_FULL]        = "full",
+    [Metrics_REJECT_HANDSHAKES]  = "handshakes",
+    [Metrics_REJECT_PEER_LIMIT]  = "peer_limit",
+};
+
+static const char* const mStartupStepNames[Metrics_NUM_STARTUP_STEPS] =
+{
+    [Metrics_STARTUP_NETWORK_STACK] = "network_stack",
+    [Metrics_STARTUP_CRYPTO]        = "crypto",
+    [Metrics_STARTUP_TLS_CONTEXTS]  = "tls_contexts",
+    [Metrics_STARTUP_TOTAL]         = "total",
+};
+
+typedef struct
+{
+    char*  buf;
+    size_t size;
+    size_t len;
+    bool   isTruncated;
+}
+Writer_t;
+
+//------------------------------------------------------------------------------
+
+static unsigned int
+getBucket(
+    const uint64_t us)
+{
+    unsigned int bucket = 0;
+
+    while (((us >> bucket) > 1) && (bucket < (Metrics_NUM_BUCKETS - 1)))
+    {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+static void
+writeLine(
+    Writer_t* const   writer,
+    const char* const format,
+    ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    const int len = vsnprintf(writer->buf + writer->len,
+                              writer->size - writer->len,
+                              format,
+                              args);
+    va_end(args);
+
+    // Keep the buffer nul-terminated, the page is discarded anyway.
+    if ((len < 0) || ((size_t)len >= (writer->size - writer->len)))
+    {
+        writer->buf[writer->len] = '\0';
+        writer->isTruncated = true;
+        return;
+    }
+
+    writer->len += (size_t)len;
+}
+
+static void
+writeMetric(
+    Writer_t* const   writer,
+    const char* const name,
+    const char* const type,
+    const char* const help,
+    const uint64_t    value)
+{
+    writeLine(writer,
+              "# HELP %s %s\n"
+              "# TYPE %s %s\n"
+              "%s %" PRIu64 "\n",
+              name, help, name, type, name, value);
+}
+
+// Prometheus expects seconds, print microseconds as such without using floats.
+static void
+writeSeconds(
+    Writer_t* const   writer,
+    const char* const name,
+    const char* const labels,
+    const uint64_t    us)
+{
+    writeLine(writer, "%s{%s} %" PRIu64 ".%06" PRIu64 "\n",
+              name, labels, us / 1000000, us % 1000000);
+}
+
+static void
+writePhases(
+    Writer_t* const writer)
+{
+    static const unsigned int percents[] = { 50, 90, 99 };
+    char labels[64];
+
+    writeLine(writer,
+              "# HELP tls_server_phase_duration_seconds Duration of the "
+              "phases of a connection.\n"
+              "# TYPE tls_server_phase_duration_seconds summary\n");
+
+    for (unsigned int phase = 0; phase < Metrics_NUM_PHASES; phase++)
+    {
+        const Metrics_Histogram_t* const histogram = &mHistograms[phase];
+
+        for (size_t i = 0; i < ARRAY_SIZE(percents); i++)
+        {
+            snprintf(labels, sizeof(labels),
+                     "phase=\"%s\",quantile=\"0.%02u\"",
+                     mPhaseNames[phase], percents[i]);
+            writeSeconds(writer, "tls_server_phase_duration_seconds", labels,
+                         Metrics_getPercentileUs(histogram, percents[i]));
+        }
+
+        snprintf(labels, sizeof(labels), "phase=\"%s\"", mPhaseNames[phase]);
+        writeSeconds(writer, "tls_server_phase_duration_seconds_sum", labels,
+                     histogram->sumUs);
+        writeLine(writer,
+                  "tls_server_phase_duration_seconds_count{%s} %" PRIu64 "\n",
+                  labels, histogram->count);
+    }
+
+    writeLine(writer,
+              "# HELP tls_server_phase_duration_max_seconds Longest duration "
+              "of the phases of a connection.\n"
+              "# TYPE tls_server_phase_duration_max_seconds gauge\n");
+
+    for (unsigned int phase = 0; phase < Metrics_NUM_PHASES; phase++)
+    {
+        snprintf(labels, sizeof(labels), "phase=\"%s\"", mPhaseNames[phase]);
+        writeSeconds(writer, "tls_server_phase_duration_max_seconds", labels,
+                     mHistograms[phase].maxUs);
+    }
+}
+
+static void
+writeTimeouts(
+    Writer_t* const writer)
+{
+    writeLine(writer,
+              "# HELP tls_server_timeouts_total Connections closed for "
+              "missing a deadline.\n"
+              "# TYPE tls_server_timeouts_total counter\n");
+
+    for (unsigned int timeout = 0; timeout < Metrics_NUM_TIMEOUTS; timeout++)
+    {
+        writeLine(writer,
+                  "tls_server_timeouts_total{phase=\"%s\"} %" PRIu64 "\n",
+                  mTimeoutNames[timeout], mTimeouts[timeout]);
+    }
+}
+
+static void
+writeRejections(
+    Writer_t* const writer)
+{
+    writeLine(writer,
+              "# HELP tls_server_rejected_connections_total Connections "
+              "closed by the admission control before the handshake.\n"
+              "# TYPE tls_server_rejected_connections_total counter\n");
+
+    for (unsigned int reason = 0; reason < Metrics_NUM_REJECTS; reason++)
+    {
+        writeLine(writer,
+                  "tls_server_rejected_connections_total{reason=\"%s\"} %"
+                  PRIu64 "\n",
+                  mRejectNames[reason], mRejections[reason]);
+    }
+}
+
+static void
+writeStartup(
+    Writer_t* const writer)
+{
+    char labels[64];
+
+    writeLine(writer,
+              "# HELP tls_server_startup_seconds Duration of the startup "
+              "steps.\n"
+              "# TYPE tls_server_startup_seconds gauge\n");
+
+    for (unsigned int step = 0; step < Metrics_NUM_STARTUP_STEPS; step++)
+    {
+        snprintf(labels, sizeof(labels), "step=\"%s\"",
+                 mStartupStepNames[step]);
+        writeSeconds(writer, "tls_server_startup_seconds", labels,
+                     mStartupUs[step]);
+    }
+}
+
+static void
+writeHandshakeFailures(
+    Writer_t* const writer)
+{
+    uint64_t other = mCounters[Metrics_COUNTER_HANDSHAKE_FAILURES];
+
+    writeLine(writer,
+              "# HELP tls_server_handshake_failures_total Failed handshakes "
+              "by OS_Error_t code.\n"
+              "# TYPE tls_server_handshake_failures_total counter\n");
+
+    for (size_t i = 0; i < mNumHandshakeErrors; i++)
+    {
+        writeLine(writer,
+                  "tls_server_handshake_failures_total{code=\"%d\"} "
+                  "%" PRIu64 "\n",
+                  mHandshakeErrors[i].code, mHandshakeErrors[i].count);
+        other -= mHandshakeErrors[i].count;
+    }
+
+    if (other > 0)
+    {
+        writeLine(writer,
+                  "tls_server_handshake_failures_total{code=\"other\"} "
+                  "%" PRIu64 "\n", other);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+Metrics_addDuration(
+    const Metrics_Phase_t phase,
+    const uint64_t        startUs,
+    const uint64_t        endUs)
+{
+    Metrics_Histogram_t* const histogram = &mHistograms[phase];
+    const uint64_t us = (endUs > startUs) ? (endUs - startUs) : 0;
+
+    histogram->count++;
+    histogram->sumUs += us;
+    if (us > histogram->maxUs)
+    {
+        histogram->maxUs = us;
+    }
+    histogram->buckets[getBucket(us)]++;
+}
+
+void
+Metrics_addCount(
+    const Metrics_Counter_t counter,
+    const uint64_t          value)
+{
+    mCounters[counter] += value;
+}
+
+void
+Metrics_addHandshakeFailure(
+    const OS_Error_t err)
+{
+    mCounters[Metrics_COUNTER_HANDSHAKE_FAILURES]++;
+
+    for (size_t i = 0; i < mNumHandshakeErrors; i++)
+    {
+        if (mHandshakeErrors[i].code == err)
+        {
+            mHandshakeErrors[i].count++;
+            return;
+        }
+    }
+
+    // Further codes are only part of the total.
+    if (mNumHandshakeErrors < ARRAY_SIZE(mHandshakeErrors))
+    {
+        mHandshakeErrors[mNumHandshakeErrors].code = err;
+        mHandshakeErrors[mNumHandshakeErrors].count = 1;
+        mNumHandshakeErrors++;
+    }
+}
+
+void
+Metrics_setStartupDuration(
+    const Metrics_StartupStep_t step,
+    const uint64_t              startUs,
+    const uint64_t              endUs)
+{
+    mStartupUs[step] = (endUs > startUs) ? (endUs - startUs) : 0;
+}
+
+void
+Metrics_addTimeout(
+    const Metrics_Timeout_t timeout)
+{
+    mTimeouts[timeout]++;
+}
+
+void
+Metrics_addRejection(
+    const Metrics_Reject_t reason)
+{
+    mRejections[reason]++;
+}
+
+const char*
+Metrics_getRejectName(
+    const Metrics_Reject_t reason)
+{
+    return mRejectNames[reason];
+}
+
+const char*
+Metrics_getTimeoutName(
+    const Metrics_Timeout_t timeout)
+{
+    return mTimeoutNames[timeout];
+}
+
+uint64_t
+Metrics_getCount(
+    const Metrics_Counter_t counter)
+{
+    return mCounters[counter];
+}
+
+const Metrics_Histogram_t*
+Metrics_getHistogram(
+    const Metrics_Phase_t phase)
+{
+    return &mHistograms[phase];
+}
+
+uint64_t
+Metrics_getPercentileUs(
+    const Metrics_Histogram_t* const histogram,
+    const unsigned int               percent)
+{
+    if (0 == histogram->count)
+    {
+        return 0;
+    }
+
+    // Rank of the percentile, rounded up.
+    const uint64_t rank = ((histogram->count * percent) + 99) / 100;
+    uint64_t sum = 0;
+
+    for (unsigned int i = 0; i < Metrics_NUM_BUCKETS; i++)
+    {
+        sum += histogram->buckets[i];
+        if (sum >= rank)
+        {
+            const uint64_t upperUs = (UINT64_C(1) << (i + 1)) - 1;
+            return (upperUs < histogram->maxUs) ? upperUs : histogram->maxUs;
+        }
+    }
+
+    return histogram->maxUs;
+}
+
+const char*
+Metrics_getPhaseName(
+    const Metrics_Phase_t phase)
+{
+    return mPhaseNames[phase];
+}
+
+void
+Metrics_logSummary(void)
+{
+    Debug_LOG_INFO("Metrics: %" PRIu64 " connections (%" PRIu64 " handshake "
+                   "failures), %" PRIu64 " requests, %" PRIu64 " bytes in, "
+                   "%" PRIu64 " bytes out (%" PRIu64 " copied), %" PRIu64
+                   " would block",
+                   mCounters[Metrics_COUNTER_CONNECTIONS],
+                   mCounters[Metrics_COUNTER_HANDSHAKE_FAILURES],
+                   mCounters[Metrics_COUNTER_REQUESTS],
+                   mCounters[Metrics_COUNTER_BYTES_IN],
+                   mCounters[Metrics_COUNTER_BYTES_OUT],
+                   mCounters[Metrics_COUNTER_BYTES_COPIED],
+                   mCounters[Metrics_COUNTER_WOULD_BLOCK]);
+    Debug_LOG_INFO("Metrics: timeouts handshake=%" PRIu64 " first_byte=%"
+                   PRIu64 " request=%" PRIu64 " response=%" PRIu64
+                   " keep_alive=%" PRIu64,
+                   mTimeouts[Metrics_TIMEOUT_HANDSHAKE],
+                   mTimeouts[Metrics_TIMEOUT_FIRST_BYTE],
+                   mTimeouts[Metrics_TIMEOUT_REQUEST],
+                   mTimeouts[Metrics_TIMEOUT_RESPONSE],
+                   mTimeouts[Metrics_TIMEOUT_KEEP_ALIVE]);
+    Debug_LOG_INFO("Metrics: rejected full=%" PRIu64 " handshakes=%" PRIu64
+                   " peer_limit=%" PRIu64,
+                   mRejections[Metrics_REJECT_FULL],
+                   mRejections[Metrics_REJECT_HANDSHAKES],
+                   mRejections[Metrics_REJECT_PEER_LIMIT]);
+
+    for (unsigned int phase = 0; phase < Metrics_NUM_PHASES; phase++)
+    {
+        const Metrics_Histogram_t* const histogram = &mHistograms[phase];
+
+        Debug_LOG_INFO("Metrics: %-14s n=%" PRIu64 " p50=%" PRIu64 "us "
+                       "p90=%" PRIu64 "us p99=%" PRIu64 "us max=%" PRIu64 "us",
+                       mPhaseNames[phase],
+                       histogram->count,
+                       Metrics_getPercentileUs(histogram, 50),
+                       Metrics_getPercentileUs(histogram, 90),
+                       Metrics_getPercentileUs(histogram, 99),
+                       histogram->maxUs);
+    }
+}
+
+size_t
+Metrics_render(
+    char* const                   buf,
+    const size_t                  size,
+    const Metrics_Gauges_t* const gauges)
+{
+    Writer_t writer =
+    {
+        .buf         = buf,
+        .size        = size,
+        .len         = 0,
+        .isTruncated = false,
+    };
+
+    writeMetric(&writer, "tls_server_connections", "gauge",
+                "Active connections.", gauges->activeConnections);
+    writeMetric(&writer, "tls_server_connections_max", "gauge",
+                "Connections served in parallel.", gauges->maxConnections);
+    writeMetric(&writer, "tls_server_connections_total", "counter",
+                "Accepted connections.",
+                mCounters[Metrics_COUNTER_CONNECTIONS]);
+    writeMetric(&writer, "tls_server_handshakes_total", "counter",
+                "Completed handshakes, the OS_Tls library does not report "
+                "the cipher suite.",
+                mHistograms[Metrics_PHASE_HANDSHAKE].count);
+    writeHandshakeFailures(&writer);
+    writeTimeouts(&writer);
+    writeRejections(&writer);
+    writeMetric(&writer, "tls_server_requests_total", "counter",
+                "Served requests.", mCounters[Metrics_COUNTER_REQUESTS]);
+    writeMetric(&writer, "tls_server_received_bytes_total", "counter",
+                "Application data received.",
+                mCounters[Metrics_COUNTER_BYTES_IN]);
+    writeMetric(&writer, "tls_server_sent_bytes_total", "counter",
+                "Application data sent.",
+                mCounters[Metrics_COUNTER_BYTES_OUT]);
+    writeMetric(&writer, "tls_server_copied_bytes_total", "counter",
+                "Application data copied between buffers of the TLS Server.",
+                mCounters[Metrics_COUNTER_BYTES_COPIED]);
+    writeMetric(&writer, "tls_server_would_block_total", "counter",
+                "Calls of the TLS library that returned "
+                "OS_ERROR_WOULD_BLOCK.",
+                mCounters[Metrics_COUNTER_WOULD_BLOCK]);
+    writeMetric(&writer, "tls_server_tls_resets_idle_total", "counter",
+                "TLS contexts reset while the server was idle.",
+                mCounters[Metrics_COUNTER_TLS_RESETS_IDLE]);
+    writeMetric(&writer, "tls_server_tls_resets_inline_total", "counter",
+                "TLS contexts reset on accept, as no prepared one was left.",
+                mCounters[Metrics_COUNTER_TLS_RESETS_INLINE]);
+    writeMetric(&writer, "tls_server_log_suppressed_total", "counter",
+                "Log records dropped by the rate limit.",
+                gauges->logSuppressed);
+    writeMetric(&writer, "tls_server_log_overflows_total", "counter",
+                "Log records lost to a full ring buffer.",
+                gauges->logOverflows);
+    writeMetric(&writer, "tls_server_arena_allocations_total", "counter",
+                "Allocations of the TLS library served by a connection arena.",
+                gauges->arenaAllocations);
+    writeMetric(&writer, "tls_server_arena_fallbacks_total", "counter",
+                "Allocations of the TLS library that fell back to the heap.",
+                gauges->arenaFallbacks);
+    writeMetric(&writer, "tls_server_arena_releases_total", "counter",
+                "Connection arenas released as a whole.",
+                gauges->arenaReleases);
+    writeMetric(&writer, "tls_server_arena_pinned_total", "counter",
+                "TLS context resets that did not release the arena of the "
+                "connection.",
+                mCounters[Metrics_COUNTER_ARENAS_PINNED]);
+    writeMetric(&writer, "tls_server_entropy_rpcs_total", "counter",
+                "Reads of the crypto library from the EntropySource.",
+                mCounters[Metrics_COUNTER_ENTROPY_RPCS]);
+    writeMetric(&writer, "tls_server_entropy_handshake_rpcs_total", "counter",
+                "Reads from the EntropySource during a step of a handshake.",
+                mCounters[Metrics_COUNTER_ENTROPY_HANDSHAKE_RPCS]);
+    writeMetric(&writer, "tls_server_arena_high_water_bytes", "gauge",
+                "Highest usage of a connection arena.",
+                gauges->arenaHighWater);
+    writeMetric(&writer, "tls_server_arena_size_bytes", "gauge",
+                "Size of a connection arena.", gauges->arenaSize);
+    writeMetric(&writer, "tls_server_heap_high_water_bytes", "gauge",
+                "Highest heap usage.", gauges->heapHighWater);
+    writeMetric(&writer, "tls_server_heap_size_bytes", "gauge",
+                "Size of the heap.", gauges->heapSize);
+    writePhases(&writer);
+    writeStartup(&writer);
+
+    // A partial page would be taken for counters that went missing.
+    if (writer.isTruncated)
+    {
+        Debug_LOG_ERROR("Metrics page exceeds %zu bytes", size);
+        return 0;
+    }
+
+    return writer.len;
+}
@@ -0,0 +1,120 @@
+/*
+ * Static content served by the TLS Server
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "StaticContent.h"
+
+#include <string.h>
+
+//------------------------------------------------------------------------------
+
+// Bytewise order, shorter paths first on a common prefix. This matches the
+// sort order of the generator.
+static int
+comparePath(
+    const char* const a,
+    const size_t      aLen,
+    const char* const b,
+    const size_t      bLen)
+{
+    const int ret = memcmp(a, b, (aLen < bLen) ? aLen : bLen);
+    if (ret != 0)
+    {
+        return ret;
+    }
+
+    return (aLen < bLen) ? -1 : ((aLen > bLen) ? 1 : 0);
+}
+
+//------------------------------------------------------------------------------
+
+const StaticContent_Entry_t*
+StaticContent_find(
+    const char* const path,
+    const size_t      pathLen)
+{
+    const char* const query = memchr(path, '?', pathLen);
+    const size_t len = (NULL != query) ? (size_t)(query - path) : pathLen;
+
+    size_t lo = 0;
+    size_t hi = StaticContent_numEntries;
+
+    while (lo < hi)
+    {
+        const size_t mid = lo + ((hi - lo) / 2);
+        const StaticContent_Entry_t* const entry = &StaticContent_entries[mid];
+
+        const int ret = comparePath(path, len, entry->path, entry->pathLen);
+        if (0 == ret)
+        {
+            return entry;
+        }
+        if (ret < 0)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1;
+        }
+    }
+
+    return NULL;
+}
+
+bool
+StaticContent_isNotModified(
+    const StaticContent_Entry_t* const entry,
+    const char* const                  ifNoneMatch,
+    const size_t                       ifNoneMatchLen)
+{
+    const char* pos = ifNoneMatch;
+    const char* const end = ifNoneMatch + ifNoneMatchLen;
+
+    // The value is either "*" or a list of entity tags (RFC 7232, 3.2), weak
+    // comparison is used.
+    while (pos < end)
+    {
+        while ((pos < end) && ((*pos == ' ') || (*pos == ',')))
+        {
+            pos++;
+        }
+
+        const char* tagEnd = pos;
+        while ((tagEnd < end) && (*tagEnd != ','))
+        {
+            tagEnd++;
+        }
+
+        size_t tagLen = (size_t)(tagEnd - pos);
+        while ((tagLen > 0) && (pos[tagLen - 1] == ' '))
+        {
+            tagLen--;
+        }
+
+        if ((tagLen == 1) && (*pos == '*'))
+        {
+            return true;
+        }
+        if ((tagLen > 2) && (0 == strncmp(pos, "W/", 2)))
+        {
+            pos += 2;
+            tagLen -= 2;
+        }
+        if ((tagLen == entry->etagLen)
+            && (0 == memcmp(pos, entry->etag, tagLen)))
+        {
+            return true;
+        }
+
+        pos = tagEnd;
+    }
+
+    return false;
+}
@@ -0,0 +1,129 @@
+/*
+ * Hashed timer wheel for the deadlines of connections
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "TimerWheel.h"
+#include "system_config.h"
+
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+
+#if (TLS_SERVER_TIMER_WHEEL_SIZE & (TLS_SERVER_TIMER_WHEEL_SIZE - 1)) != 0
+#error "TLS_SERVER_TIMER_WHEEL_SIZE must be a power of two"
+#endif
+
+#define SLOT_MASK (TLS_SERVER_TIMER_WHEEL_SIZE - 1)
+
+//------------------------------------------------------------------------------
+
+static TimerWheel_Timer_t* mSlots[TLS_SERVER_TIMER_WHEEL_SIZE];
+
+// Tick whose slot is scanned next, all slots before it are done.
+static uint64_t mCurrentTick = 0;
+static size_t mNumArmed = 0;
+
+//------------------------------------------------------------------------------
+
+void
+TimerWheel_init(
+    const uint64_t nowMs)
+{
+    mCurrentTick = nowMs / TLS_SERVER_TIMER_TICK_MS;
+}
+
+void
+TimerWheel_arm(
+    TimerWheel_Timer_t* const timer,
+    const uint64_t            deadlineMs)
+{
+    TimerWheel_cancel(timer);
+
+    // Round up, so a timer never expires before its deadline. A deadline that
+    // already passed goes into the slot scanned next.
+    timer->expiryTick = (deadlineMs + TLS_SERVER_TIMER_TICK_MS - 1)
+                        / TLS_SERVER_TIMER_TICK_MS;
+
+    const uint64_t tick = (timer->expiryTick > mCurrentTick) ?
+                          timer->expiryTick : mCurrentTick;
+    TimerWheel_Timer_t** const slot = &mSlots[tick & SLOT_MASK];
+
+    timer->next = *slot;
+    if (NULL != timer->next)
+    {
+        timer->next->pprev = &timer->next;
+    }
+    timer->pprev = slot;
+    *slot = timer;
+
+    mNumArmed++;
+}
+
+void
+TimerWheel_cancel(
+    TimerWheel_Timer_t* const timer)
+{
+    if (NULL == timer->pprev)
+    {
+        return;
+    }
+
+    *timer->pprev = timer->next;
+    if (NULL != timer->next)
+    {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+
+    mNumArmed--;
+}
+
+bool
+TimerWheel_isEmpty(void)
+{
+    return (0 == mNumArmed);
+}
+
+TimerWheel_Timer_t*
+TimerWheel_expire(
+    const uint64_t nowMs)
+{
+    const uint64_t nowTick = nowMs / TLS_SERVER_TIMER_TICK_MS;
+
+    // After a long time without a call, every slot is scanned once.
+    if ((nowTick > mCurrentTick)
+        && ((nowTick - mCurrentTick) > TLS_SERVER_TIMER_WHEEL_SIZE))
+    {
+        mCurrentTick = nowTick - TLS_SERVER_TIMER_WHEEL_SIZE;
+    }
+
+    while (mNumArmed > 0)
+    {
+        for (TimerWheel_Timer_t* timer = mSlots[mCurrentTick & SLOT_MASK];
+             NULL != timer;
+             timer = timer->next)
+        {
+            if (timer->expiryTick <= nowTick)
+            {
+                TimerWheel_cancel(timer);
+                return timer;
+            }
+        }
+
+        // The current tick is not over yet, timers may still be added to it.
+        if (mCurrentTick >= nowTick)
+        {
+            break;
+        }
+        mCurrentTick++;
+    }
+
+    return NULL;
+}
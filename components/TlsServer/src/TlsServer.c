@@ -8,16 +8,25 @@
  * For commercial licensing, contact: info.cyber@hensoldt.net
  */
 
+#include "ConnectionArena.h"
+#include "EventLog.h"
+#include "HttpParser.h"
+#include "Metrics.h"
+#include "StaticContent.h"
+#include "TimerWheel.h"
 #include "TlsServerCerts.h"
 #include "system_config.h"
 
 #include "lib_compiler/compiler.h"
 #include "lib_debug/Debug.h"
-#include <sel4/sel4.h>
 #include <camkes.h>
+#include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "interfaces/if_OS_Entropy.h"
+#include "TimeServer.h"
 
 #include "OS_Crypto.h"
 #include "OS_Error.h"
@@ -28,150 +37,1945 @@
 
 #define REQUEST_MAX_SIZE 1024
 
-#define HTTP_RESPONSE \
-    "HTTP/1.0 200 OK\r\nContent-Type: text/html\r\n\r\n" \
-    "<h2>mbed TLS Test Server</h2>\r\n" \
-    "<p>Successful connection: Hello TLS!</p>\r\n"
+// Generated response headers, also used to gather a header and the start of
+// the body into one record. Static content is sent from read-only memory.
+#define RESPONSE_MAX_SIZE TLS_SERVER_TX_GATHER_SIZE
+
+// A response consists of the header and the body at most.
+#define MAX_TX_SEGMENTS 2
+
+// Each socket of this client reports at most one event per call of
+// OS_Socket_getPendingEvents().
+#define MAX_PENDING_EVENTS TLS_SERVER_NUM_SOCKETS
+
+// Generated bodies of arbitrary size for throughput measurements.
+#define DOWNLOAD_PATH_PREFIX "/download/"
+
+// Reserved path of the metrics page.
+#define METRICS_PATH "/metrics"
+
+// Generated bodies repeat the bytes 0x00 to 0xff.
+#define STREAM_PATTERN_PERIOD 256
+
+// Events that tear down a connection regardless of what it is waiting for.
+#define CONNECTION_EVENTS_TERMINATE \
+    (OS_SOCK_EV_CLOSE | OS_SOCK_EV_FIN | OS_SOCK_EV_ERROR)
+
+// Interval for polling the state of the NetworkStack during startup.
+#define NETWORK_STACK_INIT_POLL_MS 10
+
+#define NS_PER_MS 1000000ULL
+
+// Handshakes of a TLS context before its allocations go to the arena, see
+// selectArena(). The first one creates the blinding values of the private key,
+// the second one squares them, which grows them to their final size.
+#define ARENA_WARM_UP_HANDSHAKES 2
+
+//------------------------------------------------------------------------------
+
+typedef enum
+{
+    CONNECTION_STATE_FREE = 0,
+    CONNECTION_STATE_HANDSHAKE,
+    CONNECTION_STATE_READ,
+    CONNECTION_STATE_WRITE,
+    CONNECTION_STATE_CLOSE
+}
+ConnectionState_t;
+
+// Events of a connection, see formatEvent() for their arguments.
+typedef enum
+{
+    EVENT_ACCEPTED = 0,
+    EVENT_ESTABLISHED,
+    EVENT_HANDSHAKE_FAILED,
+    EVENT_REQUEST,
+    EVENT_REJECTED,
+    EVENT_SENT,
+    EVENT_READ_CLOSED,
+    EVENT_READ_RESET,
+    EVENT_READ_FAILED,
+    EVENT_WRITE_FAILED,
+    EVENT_SOCKET_ERROR,
+    EVENT_REMOTE_CLOSED,
+    EVENT_TIMEOUT,
+    EVENT_IDLE_RECLAIMED,
+    EVENT_ADMISSION_DENIED,
+    EVENT_CLOSED
+}
+Event_t;
+
+typedef struct
+{
+    const uint8_t* data;
+    size_t         len;
+}
+TxSegment_t;
+
+typedef struct
+{
+    ConnectionState_t   state;
+    OS_Socket_Handle_t  hSocket;
+    OS_Socket_Addr_t    srcAddr;
+    OS_Tls_Handle_t     hTls;
+    // Socket events the state machine is blocked on, see processConnection().
+    uint8_t             waitEvents;
+    // Number of times the TLS layer returned OS_ERROR_WOULD_BLOCK.
+    unsigned int        numWouldBlock;
+    // Requests served on this connection so far.
+    unsigned int        numRequests;
+    // Handshakes completed with the TLS context, see selectArena().
+    unsigned int        numHandshakes;
+    // Keep the connection open after the current response.
+    bool                keepAlive;
+    // Time the last response was completed, the connection idle the longest
+    // is reclaimed first.
+    uint64_t            lastActivityMs;
+    // Deadline of the current phase, re-armed as the phase changes or a
+    // response makes progress.
+    TimerWheel_Timer_t  timer;
+    Metrics_Timeout_t   timeoutPhase;
+    uint64_t            timeoutTxTotal;
+    // Timestamps of the phases of the connection, see Metrics_Phase_t.
+    uint64_t            acceptUs;
+    uint64_t            handshakeStartUs;
+    uint64_t            handshakeEndUs;
+    uint64_t            requestUs;
+    bool                isFirstRead;
+    // The response references mMetricsPage.
+    bool                isMetricsPageUser;
+    // Parser state of the current request, its data starts at rxStart.
+    HttpParser_t        parser;
+    size_t              rxStart;
+    size_t              rxSize;
+    // Response being sent, txSize is the offset in the current segment.
+    TxSegment_t         txSegments[MAX_TX_SEGMENTS];
+    size_t              numTxSegments;
+    size_t              txSegment;
+    size_t              txSize;
+    uint64_t            txTotal;
+    unsigned int        txStatus;
+    // Part of a generated body that was not yet queued as segment.
+    uint64_t            streamOffset;
+    uint64_t            streamRemaining;
+    // Receive buffer with one extra byte to always ensure it is nul-terminated
+    // for printing it.
+    char                rxBuf[REQUEST_MAX_SIZE + 1];
+    char                txBuf[RESPONSE_MAX_SIZE];
+}
+Connection_t;
 
 //------------------------------------------------------------------------------
 
 static const if_OS_Socket_t networkStackCtx =
     IF_OS_SOCKET_ASSIGN(networkStack);
 
-// Receive buffer with one extra byte to always ensure it is nul-terminated for
-// printing it.
-static char mRxBuf[REQUEST_MAX_SIZE + 1] = {0};
+static const if_OS_Timer_t timer =
+    IF_OS_TIMER_ASSIGN(
+        timeServer_rpc,
+        timeServer_notify);
+
+static const if_OS_Entropy_t entropySource =
+    IF_OS_ENTROPY_ASSIGN(
+        entropy_rpc,
+        entropy_port);
+
+static OS_Crypto_Handle_t hCrypto;
+static OS_Socket_Handle_t hServer;
+
+// Time of the last metrics summary.
+static uint64_t mMetricsSummaryMs = 0;
+
+// Time the event loop woke up last. Events are stamped with it instead of
+// asking the TimeServer for each one.
+static uint64_t mLoopUs = 0;
+
+// The metrics page is rendered on request, but not while a response is still
+// sending the previous one. Concurrent requests get the same page then.
+static char mMetricsPage[TLS_SERVER_METRICS_PAGE_SIZE];
+static size_t mMetricsPageLen = 0;
+static size_t mNumMetricsPageUsers = 0;
+
+// Set while a step of a handshake runs, to tell the entropy RPCs on the
+// handshake path apart.
+static bool mIsInHandshake = false;
+
+// Heap break at startup, the break is never lowered by the allocator.
+static uintptr_t mHeapStart = 0;
+
+// Set if the listening socket signalled an incoming connection which could not
+// be accepted because all connection slots were in use.
+static bool mIsAcceptPending = false;
+
+static Connection_t mConnections[TLS_SERVER_MAX_CONNECTIONS];
+
+// Every chunk of a generated body is a slice of this buffer, depending only on
+// the offset of the chunk in the body.
+static uint8_t
+mStreamPattern[TLS_SERVER_TX_RECORD_SIZE + STREAM_PATTERN_PERIOD];
+
+typedef struct
+{
+    Connection_t*   slots[TLS_SERVER_MAX_CONNECTIONS];
+    size_t          size;
+} ConnectionStack_t;
+
+// Connection slots that are not in use. The TLS contexts of the ready ones are
+// reset for the next handshake, the ones of the closed ones still hold the
+// session of their previous connection, see prepareFreeConnections().
+static ConnectionStack_t mReadyConnections;
+static ConnectionStack_t mClosedConnections;
+
+//------------------------------------------------------------------------------
+
+static OS_Error_t
+waitForNetworkStackInit(
+    const if_OS_Socket_t* const ctx)
+{
+    OS_NetworkStack_State_t networkStackState;
+
+    for (;;)
+    {
+        networkStackState = OS_Socket_getStatus(ctx);
+        if (networkStackState == RUNNING)
+        {
+            // NetworkStack up and running.
+            return OS_SUCCESS;
+        }
+        else if (networkStackState == FATAL_ERROR)
+        {
+            // NetworkStack will not come up.
+            Debug_LOG_ERROR("A FATAL_ERROR occurred in the Network Stack "
+                            "component.");
+            return OS_ERROR_ABORTED;
+        }
+
+        // The NetworkStack does not signal the end of its initialization, so
+        // sleep on the TimeServer instead of spinning and try again.
+        OS_Error_t err = TimeServer_sleep(
+                             &timer,
+                             TimeServer_PRECISION_MSEC,
+                             NETWORK_STACK_INIT_POLL_MS);
+        if (OS_SUCCESS != err)
+        {
+            Debug_LOG_ERROR("TimeServer_sleep() failed, code %d", err);
+            return err;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+static uint64_t
+getTimeUs(void)
+{
+    uint64_t us = 0;
+
+    OS_Error_t err = TimeServer_getTime(&timer, TimeServer_PRECISION_USEC, &us);
+    if (OS_SUCCESS != err)
+    {
+        Debug_LOG_ERROR("TimeServer_getTime() failed, code %d", err);
+    }
+
+    return us;
+}
+
+static uint64_t
+getTimeMs(void)
+{
+    return getTimeUs() / 1000;
+}
+
+// Every read of the crypto library is an RPC to the EntropySource, they are
+// counted to see how many of them a handshake waits for.
+static size_t
+readEntropy(
+    const size_t len)
+{
+    Metrics_addCount(Metrics_COUNTER_ENTROPY_RPCS, 1);
+    if (mIsInHandshake)
+    {
+        Metrics_addCount(Metrics_COUNTER_ENTROPY_HANDSHAKE_RPCS, 1);
+    }
+
+    return entropySource.read(len);
+}
+
+//------------------------------------------------------------------------------
+
+static Connection_t*
+findConnection(
+    const int handleId)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(mConnections); i++)
+    {
+        Connection_t* conn = &mConnections[i];
+
+        if ((conn->state != CONNECTION_STATE_FREE)
+            && (conn->hSocket.handleID == handleId))
+        {
+            return conn;
+        }
+    }
+
+    return NULL;
+}
+
+static inline size_t
+getConnectionId(
+    const Connection_t* const conn)
+{
+    return (size_t)(conn - mConnections);
+}
+
+static inline void
+pushConnection(
+    ConnectionStack_t* const stack,
+    Connection_t* const      conn)
+{
+    stack->slots[stack->size++] = conn;
+}
+
+static inline Connection_t*
+popConnection(
+    ConnectionStack_t* const stack)
+{
+    return stack->slots[--stack->size];
+}
+
+static inline size_t
+getNumFreeConnections(void)
+{
+    return mReadyConnections.size + mClosedConnections.size;
+}
+
+//------------------------------------------------------------------------------
+
+// Pack a dotted IPv4 address into an event argument.
+static uint32_t
+packAddress(
+    const char* addr)
+{
+    uint32_t packed = 0;
+    uint32_t octet = 0;
+
+    for (; '\0' != *addr; addr++)
+    {
+        if ('.' == *addr)
+        {
+            packed = (packed << 8) | (octet & 0xff);
+            octet = 0;
+        }
+        else
+        {
+            octet = (octet * 10) + (uint32_t)(*addr - '0');
+        }
+    }
+
+    return (packed << 8) | (octet & 0xff);
+}
+
+// Connection events are only recorded here, they are formatted and printed by
+// drainEventLog() in a thread of lower priority than the event loop.
+static void
+logEvent(
+    const Connection_t* const conn,
+    const Event_t             event,
+    const uint32_t            arg0,
+    const uint64_t            arg1)
+{
+    EventLog_add((uint16_t)event, (uint16_t)getConnectionId(conn), arg0, arg1,
+                 mLoopUs);
+}
+
+// Events start with the index of their connection in brackets, if they belong
+// to one.
+#define EVENT_FORMAT(_fmt_) "%s%" PRIu64 ".%06" PRIu64 " " _fmt_
+#define EVENT_ARGS(_conn_, _rec_) \
+    (_conn_), \
+    ((_rec_)->timeUs / 1000000), \
+    ((_rec_)->timeUs % 1000000)
+
+static void
+formatEvent(
+    const EventLog_Record_t* record)
+{
+    const uint32_t arg0 = record->arg0;
+    const uint64_t arg1 = record->arg1;
+
+    char conn[sizeof("[65535] ")] = "";
+    if (EventLog_NO_CONNECTION != record->conn)
+    {
+        snprintf(conn, sizeof(conn), "[%u] ", (unsigned int)record->conn);
+    }
+
+    switch (record->event)
+    {
+    case EVENT_ACCEPTED:
+        Debug_LOG_INFO(EVENT_FORMAT("Connection from %u.%u.%u.%u:%" PRIu64
+                                    " accepted"),
+                       EVENT_ARGS(conn, record),
+                       (unsigned int)((arg0 >> 24) & 0xff),
+                       (unsigned int)((arg0 >> 16) & 0xff),
+                       (unsigned int)((arg0 >> 8) & 0xff),
+                       (unsigned int)(arg0 & 0xff),
+                       arg1);
+        break;
+    case EVENT_ESTABLISHED:
+        Debug_LOG_INFO(EVENT_FORMAT("TLS connection established after %"
+                                    PRIu64 " us"),
+                       EVENT_ARGS(conn, record), arg1);
+        break;
+    case EVENT_HANDSHAKE_FAILED:
+        Debug_LOG_ERROR(EVENT_FORMAT("OS_Tls_handshake() failed, code %d"),
+                        EVENT_ARGS(conn, record), (int)(int32_t)arg0);
+        break;
+    case EVENT_REQUEST:
+        Debug_LOG_INFO(EVENT_FORMAT("Received request header of %" PRIu64
+                                    " bytes"),
+                       EVENT_ARGS(conn, record), arg1);
+        break;
+    case EVENT_REJECTED:
+        Debug_LOG_WARNING(EVENT_FORMAT("Rejecting request with status %u"),
+                          EVENT_ARGS(conn, record), (unsigned int)arg0);
+        break;
+    case EVENT_SENT:
+        Debug_LOG_INFO(EVENT_FORMAT("Sent %" PRIu64 " bytes, status %u"),
+                       EVENT_ARGS(conn, record), arg1, (unsigned int)arg0);
+        break;
+    case EVENT_READ_CLOSED:
+        Debug_LOG_WARNING(EVENT_FORMAT("OS_Tls_read() connection closed by "
+                                       "network stack"),
+                          EVENT_ARGS(conn, record));
+        break;
+    case EVENT_READ_RESET:
+        Debug_LOG_WARNING(EVENT_FORMAT("OS_Tls_read() connection reset by "
+                                       "peer"),
+                          EVENT_ARGS(conn, record));
+        break;
+    case EVENT_READ_FAILED:
+        Debug_LOG_ERROR(EVENT_FORMAT("OS_Tls_read() failed, code %d, bytes "
+                                     "read %" PRIu64),
+                        EVENT_ARGS(conn, record), (int)(int32_t)arg0, arg1);
+        break;
+    case EVENT_WRITE_FAILED:
+        Debug_LOG_ERROR(EVENT_FORMAT("OS_Tls_write() failed, code %d"),
+                        EVENT_ARGS(conn, record), (int)(int32_t)arg0);
+        break;
+    case EVENT_SOCKET_ERROR:
+        Debug_LOG_ERROR(EVENT_FORMAT("OS_Socket_getPendingEvents() returned "
+                                     "OS_SOCK_EV_ERROR, code: %d"),
+                        EVENT_ARGS(conn, record), (int)(int32_t)arg0);
+        break;
+    case EVENT_REMOTE_CLOSED:
+        Debug_LOG_WARNING(EVENT_FORMAT("Connection closed by remote side"),
+                          EVENT_ARGS(conn, record));
+        break;
+    case EVENT_TIMEOUT:
+        if (Metrics_TIMEOUT_KEEP_ALIVE == arg0)
+        {
+            Debug_LOG_INFO(EVENT_FORMAT("Keep-alive timeout expired"),
+                           EVENT_ARGS(conn, record));
+            break;
+        }
+        Debug_LOG_WARNING(EVENT_FORMAT("Deadline of phase %s missed"),
+                          EVENT_ARGS(conn, record),
+                          Metrics_getTimeoutName((Metrics_Timeout_t)arg0));
+        break;
+    case EVENT_ADMISSION_DENIED:
+        Debug_LOG_WARNING(EVENT_FORMAT("Connection from %u.%u.%u.%u "
+                                       "rejected, %s"),
+                          EVENT_ARGS(conn, record),
+                          (unsigned int)((arg0 >> 24) & 0xff),
+                          (unsigned int)((arg0 >> 16) & 0xff),
+                          (unsigned int)((arg0 >> 8) & 0xff),
+                          (unsigned int)(arg0 & 0xff),
+                          Metrics_getRejectName((Metrics_Reject_t)arg1));
+        break;
+    case EVENT_IDLE_RECLAIMED:
+        Debug_LOG_INFO(EVENT_FORMAT("Closing idle connection for a new "
+                                    "client"),
+                       EVENT_ARGS(conn, record));
+        break;
+    case EVENT_CLOSED:
+        Debug_LOG_INFO(EVENT_FORMAT("TLS connection closed after %u "
+                                    "request(s)"),
+                       EVENT_ARGS(conn, record), (unsigned int)arg0);
+        Debug_LOG_DEBUG(EVENT_FORMAT("TLS layer blocked %" PRIu64 " times"),
+                        EVENT_ARGS(conn, record), arg1);
+        break;
+    default:
+        Debug_LOG_WARNING(EVENT_FORMAT("Unknown event %u"),
+                          EVENT_ARGS(conn, record),
+                          (unsigned int)record->event);
+        break;
+    }
+}
+
+// Runs in the thread of eventLog_notify at TLS_SERVER_EVENT_LOG_PRIORITY, so
+// it only gets the CPU while the event loop waits for new socket events.
+static void
+drainEventLog(
+    void* ctx)
+{
+    EventLog_drain();
+
+    // A callback fires only once, it is registered again for the next signal.
+    const int ret = eventLog_notify_reg_callback(drainEventLog, ctx);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("eventLog_notify_reg_callback() failed, code %d", ret);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+static OS_Error_t
+initTlsContext(
+    Connection_t* const conn)
+{
+    // The socket context points to the handle in the connection slot, which
+    // is set by acceptConnections() before the TLS context is used.
+    OS_Tls_Config_t tlsConfig =
+    {
+        .mode = OS_Tls_MODE_LIBRARY,
+        .library = {
+            .socket = {
+                .context    = &conn->hSocket,
+            },
+            .flags = OS_Tls_FLAG_NONE,
+            .crypto = {
+                .handle     = hCrypto,
+                .policy     = NULL,
+                .caCerts    = TLS_SERVER_ROOT_CERT,
+                .ownCert    = TLS_SERVER_CERT,
+                .privateKey = TLS_SERVER_KEY,
+                .cipherSuites = TLS_SERVER_CIPHER_SUITES
+            }
+        }
+    };
+
+    conn->numHandshakes = 0;
+
+    OS_Error_t err = OS_Tls_init(&conn->hTls, &tlsConfig);
+    if (OS_SUCCESS != err)
+    {
+        Debug_LOG_ERROR("[%zu] OS_Tls_init() failed, code %d",
+                        getConnectionId(conn), err);
+    }
+
+    return err;
+}
+
+// Set up a TLS context for every connection slot once, so accepting a
+// connection does not have to parse certificates and keys again.
+static OS_Error_t
+initConnectionPool(void)
+{
+    // The heap break gives a good enough estimate of what the TLS contexts
+    // allocate, as the TLS library uses the stdlib allocator.
+    const uintptr_t heapStart = (uintptr_t)sbrk(0);
+
+    for (size_t i = 0; i < ARRAY_SIZE(mConnections); i++)
+    {
+        Connection_t* conn = &mConnections[i];
+
+        OS_Error_t err = initTlsContext(conn);
+        if (OS_SUCCESS != err)
+        {
+            return err;
+        }
+
+        conn->timer.context = conn;
+        conn->state = CONNECTION_STATE_FREE;
+        pushConnection(&mReadyConnections, conn);
+    }
+
+    const size_t heapUsed = (uintptr_t)sbrk(0) - heapStart;
+
+    Debug_LOG_INFO("Initialized %zu TLS contexts, heap used %zu bytes "
+                   "(~%zu bytes per context), connection slot %zu bytes",
+                   ARRAY_SIZE(mConnections),
+                   heapUsed,
+                   heapUsed / ARRAY_SIZE(mConnections),
+                   sizeof(Connection_t));
+
+    return OS_SUCCESS;
+}
+
+static void
+freeConnectionPool(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(mConnections); i++)
+    {
+        if (mConnections[i].hTls != NULL)
+        {
+            OS_Tls_free(mConnections[i].hTls);
+            mConnections[i].hTls = NULL;
+        }
+    }
+
+    mReadyConnections.size  = 0;
+    mClosedConnections.size = 0;
+}
+
+// Select the arena of a connection for the allocations of the TLS library.
+// The first handshakes of a TLS context create state that lives as long as the
+// context, like the blinding values and Montgomery constants of the keys, and
+// initialize shared state of the libraries, like the time zone of the C
+// library. That state would never be freed and keep the arena from being
+// released, so it is allocated from the heap: the arena is only used once the
+// context went through ARENA_WARM_UP_HANDSHAKES handshakes.
+static void
+selectArena(
+    const Connection_t* const conn)
+{
+    ConnectionArena_select(
+        (conn->numHandshakes >= ARENA_WARM_UP_HANDSHAKES) ?
+        getConnectionId(conn) : ConnectionArena_NONE);
+}
+
+// Clear the session state of a TLS context, the configuration of the context
+// is kept for the next connection. Returns false if the slot was disabled.
+static bool
+resetTlsContext(
+    Connection_t* const conn)
+{
+    const size_t id = getConnectionId(conn);
+    const bool isArenaUsed = !ConnectionArena_isEmpty(id);
+    const uint64_t releases = ConnectionArena_getReleases(id);
+
+    // The reset frees the state of the previous session back to the arena and
+    // allocates the one of the next handshake from it.
+    selectArena(conn);
+    OS_Error_t err = OS_Tls_reset(conn->hTls);
+    ConnectionArena_select(ConnectionArena_NONE);
+
+    // Freeing the previous session must have released the arena as a whole,
+    // otherwise state that outlives a connection went to the arena.
+    if (isArenaUsed && (releases == ConnectionArena_getReleases(id)))
+    {
+        Debug_LOG_WARNING("[%zu] Arena not released by the reset", id);
+        Metrics_addCount(Metrics_COUNTER_ARENAS_PINNED, 1);
+    }
+
+    if (OS_SUCCESS == err)
+    {
+        return true;
+    }
+
+    Debug_LOG_ERROR("[%zu] OS_Tls_reset() failed, code %d", id, err);
+
+    // Try to recover the slot with a fresh context.
+    OS_Tls_free(conn->hTls);
+    conn->hTls = NULL;
+
+    if (OS_SUCCESS != initTlsContext(conn))
+    {
+        Debug_LOG_ERROR("[%zu] Connection slot disabled", id);
+        return false;
+    }
+
+    return true;
+}
+
+static Connection_t*
+acquireConnection(void)
+{
+    // Prefer a slot whose TLS context was reset while the server was idle.
+    if (mReadyConnections.size > 0)
+    {
+        return popConnection(&mReadyConnections);
+    }
+
+    while (mClosedConnections.size > 0)
+    {
+        Connection_t* const conn = popConnection(&mClosedConnections);
+
+        Metrics_addCount(Metrics_COUNTER_TLS_RESETS_INLINE, 1);
+        if (resetTlsContext(conn))
+        {
+            return conn;
+        }
+    }
+
+    return NULL;
+}
+
+// Reset the TLS contexts of closed connections while the server is idle, so a
+// burst of new connections finds them ready for the handshake.
+static void
+prepareFreeConnections(void)
+{
+    while (mClosedConnections.size > 0)
+    {
+        Connection_t* const conn = popConnection(&mClosedConnections);
+
+        // A slot that cannot be reset is disabled and not put back.
+        Metrics_addCount(Metrics_COUNTER_TLS_RESETS_IDLE, 1);
+        if (resetTlsContext(conn))
+        {
+            pushConnection(&mReadyConnections, conn);
+        }
+    }
+}
+
+static void
+releaseConnection(
+    Connection_t* const conn)
+{
+    conn->state = CONNECTION_STATE_FREE;
+
+    // Resetting the TLS context is left to the idle time of the event loop.
+    pushConnection(&mClosedConnections, conn);
+}
+
+//------------------------------------------------------------------------------
+
+static void
+openConnection(
+    Connection_t* const conn)
+{
+    conn->waitEvents       = OS_SOCK_EV_NONE;
+    conn->numWouldBlock    = 0;
+    conn->numRequests      = 0;
+    conn->keepAlive        = false;
+    conn->rxStart          = 0;
+    conn->rxSize           = 0;
+    conn->numTxSegments    = 0;
+    conn->acceptUs         = getTimeUs();
+    conn->handshakeStartUs = 0;
+    conn->isFirstRead      = true;
+    conn->isMetricsPageUser = false;
+    conn->timeoutPhase     = Metrics_NUM_TIMEOUTS;
+    conn->timeoutTxTotal   = 0;
+    memset(conn->rxBuf, 0, sizeof(conn->rxBuf));
+
+    Metrics_addCount(Metrics_COUNTER_CONNECTIONS, 1);
+
+    HttpParser_init(&conn->parser,
+                    REQUEST_MAX_SIZE,
+                    TLS_SERVER_REQUEST_BODY_MAX_SIZE);
+
+    conn->state = CONNECTION_STATE_HANDSHAKE;
+}
+
+static void
+releaseMetricsPage(
+    Connection_t* const conn)
+{
+    if (conn->isMetricsPageUser)
+    {
+        conn->isMetricsPageUser = false;
+        mNumMetricsPageUsers--;
+    }
+}
+
+static void
+closeConnection(
+    Connection_t* const conn)
+{
+    const size_t id = getConnectionId(conn);
+
+    OS_Error_t err = OS_Socket_close(conn->hSocket);
+    if (OS_SUCCESS != err)
+    {
+        Debug_LOG_ERROR("[%zu] OS_Socket_close() failed, code %d", id, err);
+    }
+
+    Metrics_addDuration(Metrics_PHASE_CONNECTION, conn->acceptUs, getTimeUs());
+    releaseMetricsPage(conn);
+
+    logEvent(conn, EVENT_CLOSED, conn->numRequests, conn->numWouldBlock);
+
+    TimerWheel_cancel(&conn->timer);
+
+    releaseConnection(conn);
+}
+
+//------------------------------------------------------------------------------
+
+static bool
+isIdleConnection(
+    const Connection_t* const conn)
+{
+    // A kept-alive connection that waits for the next request.
+    return (CONNECTION_STATE_READ == conn->state)
+           && (conn->numRequests > 0)
+           && (conn->rxStart == conn->rxSize)
+           && (0 == conn->parser.scanOffset);
+}
+
+// Phase of a connection that is blocked on the socket, the ones of a request
+// are told apart by what has been received of it.
+static Metrics_Timeout_t
+getTimeoutPhase(
+    const Connection_t* const conn)
+{
+    if (CONNECTION_STATE_HANDSHAKE == conn->state)
+    {
+        return Metrics_TIMEOUT_HANDSHAKE;
+    }
+    if (CONNECTION_STATE_WRITE == conn->state)
+    {
+        return Metrics_TIMEOUT_RESPONSE;
+    }
+    if ((conn->rxStart != conn->rxSize) || (0 != conn->parser.scanOffset))
+    {
+        return Metrics_TIMEOUT_REQUEST;
+    }
+
+    return (0 == conn->numRequests) ?
+           Metrics_TIMEOUT_FIRST_BYTE : Metrics_TIMEOUT_KEEP_ALIVE;
+}
+
+// Arm the deadline of the phase the connection is blocked in. The deadline of
+// a phase is kept while the connection stays in it, so a client that trickles
+// in data cannot extend it. Only a response that makes progress gets a new
+// one, as sending a large body may take long in total.
+static void
+updateDeadline(
+    Connection_t* const conn)
+{
+    static const uint64_t timeoutsMs[Metrics_NUM_TIMEOUTS] =
+    {
+        [Metrics_TIMEOUT_HANDSHAKE]  = TLS_SERVER_HANDSHAKE_TIMEOUT_MS,
+        [Metrics_TIMEOUT_FIRST_BYTE] = TLS_SERVER_FIRST_BYTE_TIMEOUT_MS,
+        [Metrics_TIMEOUT_REQUEST]    = TLS_SERVER_REQUEST_TIMEOUT_MS,
+        [Metrics_TIMEOUT_RESPONSE]   = TLS_SERVER_RESPONSE_TIMEOUT_MS,
+        [Metrics_TIMEOUT_KEEP_ALIVE] = TLS_SERVER_KEEP_ALIVE_TIMEOUT_MS,
+    };
+
+    if (CONNECTION_STATE_FREE == conn->state)
+    {
+        return;
+    }
+
+    const Metrics_Timeout_t phase = getTimeoutPhase(conn);
+
+    if ((phase == conn->timeoutPhase)
+        && ((Metrics_TIMEOUT_RESPONSE != phase)
+            || (conn->txTotal == conn->timeoutTxTotal)))
+    {
+        return;
+    }
+
+    conn->timeoutPhase   = phase;
+    conn->timeoutTxTotal = conn->txTotal;
+
+    // The time the event loop woke up is close enough for deadlines of
+    // seconds and saves asking the TimeServer.
+    TimerWheel_arm(&conn->timer, (mLoopUs / 1000) + timeoutsMs[phase]);
+}
+
+static const char*
+getStatusText(
+    const unsigned int status)
+{
+    switch (status)
+    {
+    case 200:
+        return "OK";
+    case 304:
+        return "Not Modified";
+    case 400:
+        return "Bad Request";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 413:
+        return "Content Too Large";
+    case 431:
+        return "Request Header Fields Too Large";
+    case 500:
+        return "Internal Server Error";
+    case 501:
+        return "Not Implemented";
+    case 505:
+        return "HTTP Version Not Supported";
+    default:
+        return "Internal Server Error";
+    }
+}
+
+static void
+setKeepAlive(
+    Connection_t* const conn,
+    const bool          isAllowed)
+{
+    conn->keepAlive =
+        isAllowed
+        && conn->parser.keepAlive
+        && ((conn->numRequests + 1) < TLS_SERVER_KEEP_ALIVE_MAX_REQUESTS);
+}
+
+static void
+startResponse(
+    Connection_t* const conn,
+    const unsigned int  status)
+{
+    conn->txStatus      = status;
+    conn->numTxSegments = 0;
+    conn->txSegment     = 0;
+    conn->txSize        = 0;
+    conn->txTotal       = 0;
+    conn->streamOffset    = 0;
+    conn->streamRemaining = 0;
+}
+
+static void
+addTxSegment(
+    Connection_t* const conn,
+    const void* const   data,
+    const size_t        len)
+{
+    Debug_ASSERT(conn->numTxSegments < MAX_TX_SEGMENTS);
+
+    if (len > 0)
+    {
+        conn->txSegments[conn->numTxSegments].data = data;
+        conn->txSegments[conn->numTxSegments].len  = len;
+        conn->numTxSegments++;
+    }
+}
+
+static void
+initStreamPattern(void)
+{
+    for (size_t i = 0; i < sizeof(mStreamPattern); i++)
+    {
+        mStreamPattern[i] = (uint8_t)(i % STREAM_PATTERN_PERIOD);
+    }
+}
+
+// Queue the next chunk of a generated body, which is at most one record.
+static void
+addStreamSegment(
+    Connection_t* const conn)
+{
+    const size_t len =
+        (conn->streamRemaining < TLS_SERVER_TX_RECORD_SIZE) ?
+        (size_t)conn->streamRemaining : TLS_SERVER_TX_RECORD_SIZE;
+
+    addTxSegment(conn,
+                 &mStreamPattern[conn->streamOffset % STREAM_PATTERN_PERIOD],
+                 len);
+
+    conn->streamOffset += len;
+    conn->streamRemaining -= len;
+}
+
+// Advance to the next segment of the response, returns false once the response
+// is complete.
+static bool
+nextTxSegment(
+    Connection_t* const conn)
+{
+    conn->txSize = 0;
+
+    if (++conn->txSegment < conn->numTxSegments)
+    {
+        return true;
+    }
+    if (0 == conn->streamRemaining)
+    {
+        return false;
+    }
+
+    conn->numTxSegments = 0;
+    conn->txSegment = 0;
+    addStreamSegment(conn);
+
+    return true;
+}
+
+// OS_Tls_write() creates at least one record per call and there is no gather
+// variant, so the header and the start of the body are copied into txBuf to
+// send them in one record. Static content keeps the header right in front of
+// the body, which needs no copy at all.
+static void
+gatherTxSegments(
+    Connection_t* const conn)
+{
+    TxSegment_t* const header = &conn->txSegments[0];
+    TxSegment_t* const body = &conn->txSegments[1];
+
+    if (conn->numTxSegments < 2)
+    {
+        return;
+    }
+    if (header->data + header->len == body->data)
+    {
+        header->len += body->len;
+        conn->numTxSegments = 1;
+        return;
+    }
+    if (header->len >= sizeof(conn->txBuf))
+    {
+        return;
+    }
+
+    uint8_t* const buf = (uint8_t*)conn->txBuf;
+    const size_t space = sizeof(conn->txBuf) - header->len;
+    const size_t len = (body->len < space) ? body->len : space;
+
+    if (header->data != buf)
+    {
+        memcpy(buf, header->data, header->len);
+        Metrics_addCount(Metrics_COUNTER_BYTES_COPIED, header->len);
+    }
+    memcpy(buf + header->len, body->data, len);
+    Metrics_addCount(Metrics_COUNTER_BYTES_COPIED, len);
+
+    header->data = buf;
+    header->len += len;
+    body->data += len;
+    body->len -= len;
+
+    if (0 == body->len)
+    {
+        conn->numTxSegments = 1;
+    }
+}
+
+static void
+prepareErrorResponse(
+    Connection_t* const conn,
+    const unsigned int  status,
+    const bool          isKeepAliveAllowed)
+{
+    setKeepAlive(conn, isKeepAliveAllowed);
+
+    const int len = snprintf(
+                        conn->txBuf,
+                        sizeof(conn->txBuf),
+                        "HTTP/1.1 %u %s\r\n"
+                        "%s"
+                        "Content-Length: 0\r\n"
+                        "Connection: %s\r\n"
+                        "\r\n",
+                        status,
+                        getStatusText(status),
+                        (405 == status) ? "Allow: GET, HEAD\r\n" : "",
+                        conn->keepAlive ? "keep-alive" : "close");
+
+    Debug_ASSERT((len > 0) && ((size_t)len < sizeof(conn->txBuf)));
+
+    startResponse(conn, status);
+    addTxSegment(conn, conn->txBuf, (size_t)len);
+}
+
+// Check for DOWNLOAD_PATH_PREFIX followed by the body size in bytes.
+static bool
+parseDownloadPath(
+    const char* const path,
+    const size_t      len,
+    uint64_t* const   size)
+{
+    const size_t prefixLen = sizeof(DOWNLOAD_PATH_PREFIX) - 1;
+
+    if ((len <= prefixLen)
+        || (0 != memcmp(path, DOWNLOAD_PATH_PREFIX, prefixLen)))
+    {
+        return false;
+    }
+
+    *size = 0;
+    size_t pos = prefixLen;
+    for (; (pos < len) && (path[pos] != '?'); pos++)
+    {
+        // More than 12 digits are beyond any sensible download size.
+        if ((path[pos] < '0') || (path[pos] > '9') || (pos - prefixLen >= 12))
+        {
+            return false;
+        }
+        *size = (*size * 10) + (uint64_t)(path[pos] - '0');
+    }
+
+    return (pos > prefixLen);
+}
+
+static void
+prepareDownloadResponse(
+    Connection_t* const conn,
+    const uint64_t      size,
+    const bool          isHead)
+{
+    setKeepAlive(conn, true);
+
+    const int len = snprintf(
+                        conn->txBuf,
+                        sizeof(conn->txBuf),
+                        "HTTP/1.1 200 OK\r\n"
+                        "Content-Type: application/octet-stream\r\n"
+                        "Content-Length: %" PRIu64 "\r\n"
+                        "Connection: %s\r\n"
+                        "\r\n",
+                        size,
+                        conn->keepAlive ? "keep-alive" : "close");
+
+    Debug_ASSERT((len > 0) && ((size_t)len < sizeof(conn->txBuf)));
+
+    startResponse(conn, 200);
+    addTxSegment(conn, conn->txBuf, (size_t)len);
+
+    if (!isHead)
+    {
+        conn->streamRemaining = size;
+        addStreamSegment(conn);
+    }
+}
+
+static bool
+isMetricsPath(
+    const char* const path,
+    const size_t      len)
+{
+    const size_t metricsLen = sizeof(METRICS_PATH) - 1;
+
+    return (len >= metricsLen)
+           && (0 == memcmp(path, METRICS_PATH, metricsLen))
+           && ((len == metricsLen) || ('?' == path[metricsLen]));
+}
+
+static void
+prepareMetricsResponse(
+    Connection_t* const conn,
+    const bool          isHead)
+{
+    if (0 == mNumMetricsPageUsers)
+    {
+        EventLog_Stats_t logStats;
+        EventLog_getStats(&logStats);
+
+        ConnectionArena_Stats_t arenaStats;
+        ConnectionArena_getStats(&arenaStats);
+
+        const Metrics_Gauges_t gauges =
+        {
+            .activeConnections =
+                ARRAY_SIZE(mConnections) - getNumFreeConnections(),
+            .maxConnections    = ARRAY_SIZE(mConnections),
+            .heapHighWater     = (uintptr_t)sbrk(0) - mHeapStart,
+            .heapSize          = TLS_SERVER_HEAP_SIZE,
+            .logSuppressed     = logStats.suppressed,
+            .logOverflows      = logStats.overflows,
+            .arenaAllocations  = arenaStats.allocations,
+            .arenaFallbacks    = arenaStats.fallbacks,
+            .arenaReleases     = arenaStats.releases,
+            .arenaHighWater    = arenaStats.highWater,
+            .arenaSize         = TLS_SERVER_CONNECTION_ARENA_SIZE,
+        };
+
+        mMetricsPageLen = Metrics_render(mMetricsPage,
+                                         sizeof(mMetricsPage),
+                                         &gauges);
+    }
+
+    if (0 == mMetricsPageLen)
+    {
+        prepareErrorResponse(conn, 500, true);
+        return;
+    }
+
+    setKeepAlive(conn, true);
+
+    const int len = snprintf(
+                        conn->txBuf,
+                        sizeof(conn->txBuf),
+                        "HTTP/1.1 200 OK\r\n"
+                        "Content-Type: text/plain; version=0.0.4\r\n"
+                        "Content-Length: %zu\r\n"
+                        "Connection: %s\r\n"
+                        "\r\n",
+                        mMetricsPageLen,
+                        conn->keepAlive ? "keep-alive" : "close");
+
+    Debug_ASSERT((len > 0) && ((size_t)len < sizeof(conn->txBuf)));
+
+    startResponse(conn, 200);
+    addTxSegment(conn, conn->txBuf, (size_t)len);
+
+    if (!isHead)
+    {
+        addTxSegment(conn, mMetricsPage, mMetricsPageLen);
+        conn->isMetricsPageUser = true;
+        mNumMetricsPageUsers++;
+    }
+}
+
+// Select the response for a complete request header. The parser only
+// references the header, so this must happen while it is in the receive
+// buffer.
+static void
+prepareContentResponse(
+    Connection_t* const conn,
+    const char* const   data)
+{
+    const HttpParser_t* const parser = &conn->parser;
+
+    const bool isHead = HttpParser_isMethod(parser, data, "HEAD");
+    if (!isHead && !HttpParser_isMethod(parser, data, "GET"))
+    {
+        prepareErrorResponse(conn, 405, true);
+        return;
+    }
+
+    const char* const path = data + parser->target.offset;
+    if (isMetricsPath(path, parser->target.len))
+    {
+        prepareMetricsResponse(conn, isHead);
+        return;
+    }
+
+    const StaticContent_Entry_t* const entry =
+        StaticContent_find(path, parser->target.len);
+    if (NULL == entry)
+    {
+        uint64_t size;
+        if (parseDownloadPath(path, parser->target.len, &size)
+            && (size <= TLS_SERVER_DOWNLOAD_MAX_SIZE))
+        {
+            prepareDownloadResponse(conn, size, isHead);
+        }
+        else
+        {
+            prepareErrorResponse(conn, 404, true);
+        }
+        return;
+    }
+
+    setKeepAlive(conn, true);
+
+    HttpParser_Span_t ifNoneMatch;
+    if (HttpParser_getHeader(parser, data, "If-None-Match", &ifNoneMatch)
+        && StaticContent_isNotModified(entry,
+                                       data + ifNoneMatch.offset,
+                                       ifNoneMatch.len))
+    {
+        startResponse(conn, 304);
+        addTxSegment(conn,
+                     entry->notModified[conn->keepAlive],
+                     entry->notModifiedLen[conn->keepAlive]);
+        return;
+    }
+
+    startResponse(conn, 200);
+    addTxSegment(conn,
+                 entry->header[conn->keepAlive],
+                 entry->headerLen[conn->keepAlive]);
+    if (!isHead)
+    {
+        addTxSegment(conn, entry->body, entry->bodyLen);
+    }
+}
+
+// Process the received data of the current request. Returns true once the
+// request is complete and the response is prepared.
+static bool
+handleRequestData(
+    Connection_t* const conn)
+{
+    HttpParser_t* const parser = &conn->parser;
+    const char* const data = conn->rxBuf + conn->rxStart;
+    const size_t size = conn->rxSize - conn->rxStart;
+
+    if (0 == parser->headerSize)
+    {
+        switch (HttpParser_parseHeader(parser, data, size))
+        {
+        case HttpParser_RESULT_COMPLETE:
+            logEvent(conn, EVENT_REQUEST, 0, parser->headerSize);
+            Debug_LOG_DEBUG("[%zu] Request:\n%.*s", getConnectionId(conn),
+                            (int)parser->headerSize, data);
+
+            prepareContentResponse(conn, data);
+            conn->rxStart += parser->headerSize;
+            break;
+        case HttpParser_RESULT_ERROR:
+            logEvent(conn, EVENT_REJECTED, parser->status, 0);
+            // The rest of the request cannot be trusted, so the connection
+            // is closed after the response.
+            prepareErrorResponse(conn, parser->status, false);
+            return true;
+        case HttpParser_RESULT_INCOMPLETE:
+        default:
+            return false;
+        }
+    }
+
+    // The body of a request is not used, it is dropped as it arrives.
+    conn->rxStart += HttpParser_consumeBody(parser,
+                                            conn->rxSize - conn->rxStart);
+
+    return (0 == parser->bodyRemaining);
+}
+
+// Make room at the end of the receive buffer.
+static void
+compactRxBuffer(
+    Connection_t* const conn)
+{
+    if (conn->rxStart == conn->rxSize)
+    {
+        conn->rxStart = 0;
+        conn->rxSize = 0;
+    }
+    else if ((REQUEST_MAX_SIZE == conn->rxSize) && (conn->rxStart > 0))
+    {
+        memmove(conn->rxBuf,
+                conn->rxBuf + conn->rxStart,
+                conn->rxSize - conn->rxStart);
+        Metrics_addCount(Metrics_COUNTER_BYTES_COPIED,
+                         conn->rxSize - conn->rxStart);
+        conn->rxSize -= conn->rxStart;
+        conn->rxStart = 0;
+    }
+
+    conn->rxBuf[conn->rxSize] = '\0';
+}
+
+//------------------------------------------------------------------------------
+
+// Drive the state machine of a connection as far as possible without
+// blocking. Returns as soon as the TLS layer reports OS_ERROR_WOULD_BLOCK and
+// records in waitEvents which socket event lets the connection continue where
+// it stopped.
+static void
+runStateMachine(
+    Connection_t* const conn)
+{
+    OS_Error_t err;
+
+    conn->waitEvents = OS_SOCK_EV_NONE;
+
+    for (;;)
+    {
+        switch (conn->state)
+        {
+        // ---------------------------------------------------------------------
+        case CONNECTION_STATE_HANDSHAKE:
+        {
+            const uint64_t stepStartUs = getTimeUs();
+            if (0 == conn->handshakeStartUs)
+            {
+                conn->handshakeStartUs = stepStartUs;
+                Metrics_addDuration(Metrics_PHASE_ACCEPT,
+                                    conn->acceptUs,
+                                    conn->handshakeStartUs);
+            }
+            mIsInHandshake = true;
+            err = OS_Tls_handshake(conn->hTls);
+            mIsInHandshake = false;
+
+            // The private key operations run inline, no other connection is
+            // served during a step of the handshake.
+            const uint64_t stepEndUs = getTimeUs();
+            Metrics_addDuration(Metrics_PHASE_HANDSHAKE_STEP,
+                                stepStartUs,
+                                stepEndUs);
+
+            if (OS_ERROR_WOULD_BLOCK == err)
+            {
+                // The handshake alternates between reading and writing
+                // records, so either event may unblock it.
+                conn->waitEvents = OS_SOCK_EV_READ | OS_SOCK_EV_WRITE;
+                conn->numWouldBlock++;
+                Metrics_addCount(Metrics_COUNTER_WOULD_BLOCK, 1);
+                return;
+            }
+            if (OS_SUCCESS != err)
+            {
+                logEvent(conn, EVENT_HANDSHAKE_FAILED, (uint32_t)err, 0);
+                Metrics_addHandshakeFailure(err);
+                conn->state = CONNECTION_STATE_CLOSE;
+                break;
+            }
+            conn->handshakeEndUs = stepEndUs;
+            Metrics_addDuration(Metrics_PHASE_HANDSHAKE,
+                                conn->handshakeStartUs,
+                                conn->handshakeEndUs);
+            logEvent(conn, EVENT_ESTABLISHED, 0,
+                     conn->handshakeEndUs - conn->handshakeStartUs);
+            conn->numHandshakes++;
+            conn->state = CONNECTION_STATE_READ;
+            break;
+        }
+
+        // ---------------------------------------------------------------------
+        case CONNECTION_STATE_READ:
+        {
+            // Serve requests that are already buffered first, a client may
+            // have pipelined several of them.
+            if (handleRequestData(conn))
+            {
+                conn->requestUs = getTimeUs();
+                gatherTxSegments(conn);
+                conn->state = CONNECTION_STATE_WRITE;
+                break;
+            }
+
+            compactRxBuffer(conn);
+
+            size_t dataSize = REQUEST_MAX_SIZE - conn->rxSize;
+
+            err = OS_Tls_read(conn->hTls,
+                              (conn->rxBuf + conn->rxSize),
+                              &dataSize);
+            switch (err)
+            {
+            case OS_SUCCESS:
+                conn->rxSize += dataSize;
+                conn->rxBuf[conn->rxSize] = '\0';
+                Metrics_addCount(Metrics_COUNTER_BYTES_IN, dataSize);
+                if (conn->isFirstRead)
+                {
+                    conn->isFirstRead = false;
+                    Metrics_addDuration(Metrics_PHASE_FIRST_BYTE,
+                                        conn->handshakeEndUs,
+                                        getTimeUs());
+                }
+                break;
+            case OS_ERROR_WOULD_BLOCK:
+                conn->waitEvents = OS_SOCK_EV_READ;
+                conn->numWouldBlock++;
+                Metrics_addCount(Metrics_COUNTER_WOULD_BLOCK, 1);
+                return;
+            case OS_ERROR_CONNECTION_CLOSED:
+                logEvent(conn, EVENT_READ_CLOSED, 0, 0);
+                conn->state = CONNECTION_STATE_CLOSE;
+                break;
+            case OS_ERROR_NETWORK_CONN_SHUTDOWN:
+                logEvent(conn, EVENT_READ_RESET, 0, 0);
+                conn->state = CONNECTION_STATE_CLOSE;
+                break;
+            default:
+                logEvent(conn, EVENT_READ_FAILED, (uint32_t)err,
+                         conn->rxSize);
+                conn->state = CONNECTION_STATE_CLOSE;
+                break;
+            }
+            break;
+        }
+
+        // ---------------------------------------------------------------------
+        case CONNECTION_STATE_WRITE:
+        {
+            const TxSegment_t* const segment =
+                &conn->txSegments[conn->txSegment];
+            size_t dataSize = segment->len - conn->txSize;
+
+            err = OS_Tls_write(conn->hTls,
+                               (segment->data + conn->txSize),
+                               &dataSize);
+            switch (err)
+            {
+            case OS_SUCCESS:
+                conn->txSize  += dataSize;
+                conn->txTotal += dataSize;
+                Metrics_addCount(Metrics_COUNTER_BYTES_OUT, dataSize);
+                // Further chunks of a streamed body are queued as the previous
+                // one is sent, partial writes just continue once the socket
+                // is writable again.
+                if ((conn->txSize == segment->len) && !nextTxSegment(conn))
+                {
+                    logEvent(conn, EVENT_SENT, conn->txStatus,
+                             conn->txTotal);
+
+                    Metrics_addDuration(Metrics_PHASE_RESPONSE,
+                                        conn->requestUs,
+                                        getTimeUs());
+                    Metrics_addCount(Metrics_COUNTER_REQUESTS, 1);
+                    releaseMetricsPage(conn);
+
+                    conn->numRequests++;
+                    HttpParser_init(&conn->parser,
+                                    REQUEST_MAX_SIZE,
+                                    TLS_SERVER_REQUEST_BODY_MAX_SIZE);
+
+                    if (conn->keepAlive)
+                    {
+                        conn->lastActivityMs = getTimeMs();
+                        conn->state = CONNECTION_STATE_READ;
+                    }
+                    else
+                    {
+                        conn->state = CONNECTION_STATE_CLOSE;
+                    }
+                }
+                break;
+            case OS_ERROR_WOULD_BLOCK:
+                conn->waitEvents = OS_SOCK_EV_WRITE;
+                conn->numWouldBlock++;
+                Metrics_addCount(Metrics_COUNTER_WOULD_BLOCK, 1);
+                return;
+            default:
+                logEvent(conn, EVENT_WRITE_FAILED, (uint32_t)err, 0);
+                conn->state = CONNECTION_STATE_CLOSE;
+                break;
+            }
+            break;
+        }
+
+        // ---------------------------------------------------------------------
+        case CONNECTION_STATE_CLOSE:
+            closeConnection(conn);
+            return;
+
+        // ---------------------------------------------------------------------
+        case CONNECTION_STATE_FREE:
+        default:
+            return;
+        }
+    }
+}
+
+// Everything the TLS library allocates for the connection in the meantime goes
+// to the arena of its slot.
+static void
+processConnection(
+    Connection_t* const conn)
+{
+    selectArena(conn);
+    runStateMachine(conn);
+    ConnectionArena_select(ConnectionArena_NONE);
+
+    updateDeadline(conn);
+}
+
+//------------------------------------------------------------------------------
+
+// Close the connections that missed the deadline of their current phase.
+static void
+expireConnections(void)
+{
+    if (TimerWheel_isEmpty())
+    {
+        return;
+    }
+
+    TimerWheel_Timer_t* timer;
+
+    while (NULL != (timer = TimerWheel_expire(mLoopUs / 1000)))
+    {
+        Connection_t* const conn = timer->context;
+
+        logEvent(conn, EVENT_TIMEOUT, conn->timeoutPhase, 0);
+        Metrics_addTimeout(conn->timeoutPhase);
+        closeConnection(conn);
+    }
+}
+
+static Connection_t*
+findOldestIdleConnection(void)
+{
+    Connection_t* oldest = NULL;
+
+    for (size_t i = 0; i < ARRAY_SIZE(mConnections); i++)
+    {
+        Connection_t* conn = &mConnections[i];
+
+        if (isIdleConnection(conn)
+            && ((NULL == oldest)
+                || (conn->lastActivityMs < oldest->lastActivityMs)))
+        {
+            oldest = conn;
+        }
+    }
+
+    return oldest;
+}
+
+// Close the kept-alive connection that has been idle the longest to make room
+// for a new client. Returns false if there is no idle connection.
+static bool
+reclaimIdleConnection(void)
+{
+    Connection_t* const oldest = findOldestIdleConnection();
+
+    if (NULL == oldest)
+    {
+        return false;
+    }
+
+    logEvent(oldest, EVENT_IDLE_RECLAIMED, 0, 0);
+    closeConnection(oldest);
+
+    return true;
+}
+
+// Decide whether a new client is served before any crypto work is spent on
+// it. Handshakes in progress are capped separately from the established
+// connections, as they are what costs the server most, and a single client may
+// only hold a part of the slots.
+static bool
+admitConnection(
+    const OS_Socket_Addr_t* const srcAddr,
+    Metrics_Reject_t* const       reason)
+{
+    size_t numHandshakes = 0;
+    size_t numPeerConnections = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(mConnections); i++)
+    {
+        const Connection_t* const conn = &mConnections[i];
+
+        if (CONNECTION_STATE_FREE == conn->state)
+        {
+            continue;
+        }
+        if (CONNECTION_STATE_HANDSHAKE == conn->state)
+        {
+            numHandshakes++;
+        }
+        // Idle connections do not count, they are reclaimed for new clients
+        // anyway.
+        if (!isIdleConnection(conn)
+            && (0 == strcmp(conn->srcAddr.addr, srcAddr->addr)))
+        {
+            numPeerConnections++;
+        }
+    }
+
+    if (numHandshakes >= TLS_SERVER_MAX_HANDSHAKES)
+    {
+        *reason = Metrics_REJECT_HANDSHAKES;
+        return false;
+    }
+    if (numPeerConnections >= TLS_SERVER_MAX_CONNECTIONS_PER_PEER)
+    {
+        *reason = Metrics_REJECT_PEER_LIMIT;
+        return false;
+    }
 
-//------------------------------------------------------------------------------
+    return true;
+}
 
-static OS_Error_t
-waitForNetworkStackInit(
-    const if_OS_Socket_t* const ctx)
+// Close an accepted socket right away, the client learns immediately that it
+// has to come back later instead of waiting for a handshake.
+static void
+rejectConnection(
+    const OS_Socket_Handle_t      hSocket,
+    const OS_Socket_Addr_t* const srcAddr,
+    const Metrics_Reject_t        reason)
 {
-    OS_NetworkStack_State_t networkStackState;
+    OS_Error_t err = OS_Socket_close(hSocket);
+    if (OS_SUCCESS != err)
+    {
+        Debug_LOG_ERROR("OS_Socket_close() failed, code %d", err);
+    }
+
+    Metrics_addRejection(reason);
+
+    EventLog_add(EVENT_ADMISSION_DENIED, EventLog_NO_CONNECTION,
+                 packAddress(srcAddr->addr), reason, mLoopUs);
+}
 
+// Accept incoming connections until the backlog of the listening socket is
+// empty. Connections that are not admitted or find all slots in use are
+// rejected, unless TLS_SERVER_REJECT_WHEN_FULL is false and they are left in
+// the backlog.
+static void
+acceptConnections(void)
+{
     for (;;)
     {
-        networkStackState = OS_Socket_getStatus(ctx);
-        if (networkStackState == RUNNING)
+        const bool isFull = (0 == getNumFreeConnections())
+                            && (NULL == findOldestIdleConnection());
+
+        if (isFull && !TLS_SERVER_REJECT_WHEN_FULL)
         {
-            // NetworkStack up and running.
-            return OS_SUCCESS;
+            Debug_LOG_DEBUG("All %zu connection slots in use, deferring "
+                            "accept", ARRAY_SIZE(mConnections));
+            mIsAcceptPending = true;
+            return;
         }
-        else if (networkStackState == FATAL_ERROR)
+
+        OS_Socket_Handle_t hSocket;
+        OS_Socket_Addr_t srcAddr;
+
+        OS_Error_t err = OS_Socket_accept(hServer, &hSocket, &srcAddr);
+        if (OS_SUCCESS != err)
         {
-            // NetworkStack will not come up.
-            Debug_LOG_ERROR("A FATAL_ERROR occurred in the Network Stack "
-                            "component.");
-            return OS_ERROR_ABORTED;
+            if (OS_ERROR_TRY_AGAIN != err)
+            {
+                Debug_LOG_ERROR("OS_Socket_accept() failed, code %d", err);
+            }
+            mIsAcceptPending = false;
+            return;
+        }
+
+        Metrics_Reject_t reason = Metrics_REJECT_FULL;
+        Connection_t* conn = NULL;
+
+        if (!isFull && admitConnection(&srcAddr, &reason))
+        {
+            conn = acquireConnection();
+            if ((NULL == conn) && reclaimIdleConnection())
+            {
+                conn = acquireConnection();
+            }
+        }
+        if (NULL == conn)
+        {
+            rejectConnection(hSocket, &srcAddr, reason);
+            continue;
         }
 
-        seL4_Yield(); // Yield and try again next time.
+        // The TLS context refers to the handle in the connection slot.
+        conn->hSocket = hSocket;
+        conn->srcAddr = srcAddr;
+
+        logEvent(conn, EVENT_ACCEPTED, packAddress(conn->srcAddr.addr),
+                 conn->srcAddr.port);
+
+        openConnection(conn);
+
+        // There may already be handshake data waiting for us.
+        processConnection(conn);
+    }
+}
+
+static OS_Error_t
+handleServerEvent(
+    const OS_Socket_Evt_t* const event)
+{
+    // Socket has been closed by NetworkStack component.
+    if (event->eventMask & OS_SOCK_EV_FIN)
+    {
+        Debug_LOG_ERROR("OS_Socket_getPendingEvents() returned "
+                        "OS_SOCK_EV_FIN for handle: %d",
+                        event->socketHandle);
+        return OS_ERROR_NETWORK_CONN_REFUSED;
+    }
+
+    // Error received - print error.
+    if (event->eventMask & OS_SOCK_EV_ERROR)
+    {
+        Debug_LOG_ERROR("OS_Socket_getPendingEvents() returned "
+                        "OS_SOCK_EV_ERROR for handle: %d, code: %d",
+                        event->socketHandle, event->currentError);
+        return event->currentError;
+    }
+
+    // Incoming connection received.
+    if (event->eventMask & OS_SOCK_EV_CONN_ACPT)
+    {
+        Debug_LOG_DEBUG("OS_Socket_getPendingEvents() returned "
+                        "connection established for handle: %d",
+                        event->socketHandle);
+        acceptConnections();
+    }
+
+    return OS_SUCCESS;
+}
+
+static void
+handleConnectionEvent(
+    const OS_Socket_Evt_t* const event)
+{
+    Connection_t* conn = findConnection(event->socketHandle);
+    if (NULL == conn)
+    {
+        // Events may still arrive for a socket that we closed already.
+        Debug_LOG_DEBUG("Ignoring event 0x%x for unknown handle: %d",
+                        event->eventMask, event->socketHandle);
+        return;
+    }
+
+    // Only resume the state machine if the socket became ready for what it is
+    // blocked on, anything else would just end in OS_ERROR_WOULD_BLOCK again.
+    // Data still available before a teardown is consumed in any case.
+    if (event->eventMask & (conn->waitEvents | CONNECTION_EVENTS_TERMINATE))
+    {
+        processConnection(conn);
+    }
+
+    if (CONNECTION_STATE_FREE == conn->state)
+    {
+        return;
+    }
+
+    if (event->eventMask & OS_SOCK_EV_ERROR)
+    {
+        logEvent(conn, EVENT_SOCKET_ERROR, (uint32_t)event->currentError, 0);
+        closeConnection(conn);
+    }
+    else if (event->eventMask & (OS_SOCK_EV_CLOSE | OS_SOCK_EV_FIN))
+    {
+        logEvent(conn, EVENT_REMOTE_CLOSED, 0, 0);
+        closeConnection(conn);
+    }
+}
+
+// Record the duration of a startup step, returns the current time as start of
+// the next one.
+static uint64_t
+finishStartupStep(
+    const Metrics_StartupStep_t step,
+    const uint64_t              startUs)
+{
+    const uint64_t nowUs = getTimeUs();
+
+    Metrics_setStartupDuration(step, startUs, nowUs);
+
+    return nowUs;
+}
+
+// Log a summary of the metrics every TLS_SERVER_METRICS_INTERVAL_MS, as long as
+// there is any activity.
+static void
+logMetricsSummary(void)
+{
+    const uint64_t nowMs = getTimeMs();
+
+    if ((nowMs - mMetricsSummaryMs) >= TLS_SERVER_METRICS_INTERVAL_MS)
+    {
+        mMetricsSummaryMs = nowMs;
+        Metrics_logSummary();
+
+        ConnectionArena_Stats_t arenaStats;
+        ConnectionArena_getStats(&arenaStats);
+
+        Debug_LOG_INFO("Arenas: %" PRIu64 " allocations, %" PRIu64
+                       " fallbacks, high water %zu of %zu bytes",
+                       arenaStats.allocations, arenaStats.fallbacks,
+                       arenaStats.highWater,
+                       (size_t)TLS_SERVER_CONNECTION_ARENA_SIZE);
+    }
+}
+
+// Runs in the thread of timeServer_notify every TLS_SERVER_TIMER_TICK_MS.
+// The event loop holds loopLock except while it waits for the NetworkStack, so
+// connections that see no event anymore are expired here without the loop
+// ever polling the sockets. Events still pending for a socket closed here are
+// ignored by the loop.
+static void
+handleTimerTick(
+    void* ctx)
+{
+    // Acknowledge the tick, the periodic timer keeps running.
+    timeServer_rpc_completed();
+
+    loopLock_lock();
+
+    mLoopUs = getTimeUs();
+    expireConnections();
+    if (mIsAcceptPending)
+    {
+        acceptConnections();
+    }
+    if (EventLog_hasRecords())
+    {
+        eventLog_signal_emit();
+    }
+
+    loopLock_unlock();
+
+    // A callback fires only once, it is registered again for the next tick.
+    const int ret = timeServer_notify_reg_callback(handleTimerTick, ctx);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("timeServer_notify_reg_callback() failed, code %d",
+                        ret);
+    }
+}
+
+// Block until the NetworkStack signals events, deadlines are left to
+// handleTimerTick() meanwhile.
+static OS_Error_t
+waitForEvents(void)
+{
+    loopLock_unlock();
+    const OS_Error_t ret = OS_Socket_wait(&networkStackCtx);
+    loopLock_lock();
+
+    if (ret != OS_SUCCESS)
+    {
+        Debug_LOG_ERROR("OS_Socket_wait() failed, code %d", ret);
     }
+    return ret;
 }
 
+// Wait for events, expire missed deadlines and dispatch all pending events to
+// the listening socket or the connection they belong to.
 static OS_Error_t
-waitForIncomingConnection(
-    const int srvHandleId)
+waitAndDispatchEvents(void)
 {
-    OS_Error_t ret;
+    OS_Error_t ret = waitForEvents();
+    if (ret != OS_SUCCESS)
+    {
+        return ret;
+    }
 
-    // Wait for the event letting us know that the connection was successfully
-    // established.
     for (;;)
     {
-        ret = OS_Socket_wait(&networkStackCtx);
-        if (ret != OS_SUCCESS)
+        char evtBuffer[MAX_PENDING_EVENTS * sizeof(OS_Socket_Evt_t)];
+        int numberOfSocketsWithEvents;
+
+        mLoopUs = getTimeUs();
+
+        // Deadlines are checked before any event is handled, so a slot freed by
+        // an expired connection is available to the connections accepted then.
+        expireConnections();
+
+        // A closed connection frees up a slot for a connection that is still
+        // waiting in the backlog of the listening socket.
+        if (mIsAcceptPending)
         {
-            Debug_LOG_ERROR("OS_Socket_wait() failed, code %d", ret);
-            break;
+            acceptConnections();
         }
 
-        char evtBuffer[128];
-        const size_t evtBufferSize = sizeof(evtBuffer);
-        int numberOfSocketsWithEvents;
-
         ret = OS_Socket_getPendingEvents(
                   &networkStackCtx,
                   evtBuffer,
-                  evtBufferSize,
+                  sizeof(evtBuffer),
                   &numberOfSocketsWithEvents);
         if (ret != OS_SUCCESS)
         {
             Debug_LOG_ERROR("OS_Socket_getPendingEvents() failed, code %d",
                             ret);
-            break;
+            return ret;
         }
 
+        // Events of a socket closed by handleTimerTick() may have gone.
         if (numberOfSocketsWithEvents == 0)
         {
             Debug_LOG_TRACE("OS_Socket_getPendingEvents() returned without any "
                             "pending events");
-            continue;
-        }
-
-        // We only opened one socket, so if we get more events, this is not ok.
-        if (numberOfSocketsWithEvents != 1)
-        {
-            Debug_LOG_ERROR("OS_Socket_getPendingEvents() returned with "
-                            "unexpected #events: %d", numberOfSocketsWithEvents);
-            ret = OS_ERROR_INVALID_STATE;
-            break;
-        }
-
-        OS_Socket_Evt_t event;
-        memcpy(&event, evtBuffer, sizeof(event));
-
-        if (event.socketHandle != srvHandleId)
-        {
-            Debug_LOG_ERROR("Unexpected handle received: %d, expected: %d",
-                            event.socketHandle, srvHandleId);
-            ret = OS_ERROR_INVALID_HANDLE;
-            break;
         }
 
-        // Socket has been closed by NetworkStack component.
-        if (event.eventMask & OS_SOCK_EV_FIN)
+        for (int i = 0; i < numberOfSocketsWithEvents; i++)
         {
-            Debug_LOG_ERROR("OS_Socket_getPendingEvents() returned "
-                            "OS_SOCK_EV_FIN for handle: %d",
-                            event.socketHandle);
-            ret = OS_ERROR_NETWORK_CONN_REFUSED;
-            break;
-        }
+            OS_Socket_Evt_t event;
+            memcpy(&event,
+                   &evtBuffer[i * sizeof(OS_Socket_Evt_t)],
+                   sizeof(event));
 
-        // Incoming connection received.
-        if (event.eventMask & OS_SOCK_EV_CONN_ACPT)
-        {
-            Debug_LOG_DEBUG("OS_Socket_getPendingEvents() returned "
-                            "connection established for handle: %d",
-                            event.socketHandle);
-            ret = OS_SUCCESS;
-            break;
+            if (event.socketHandle == hServer.handleID)
+            {
+                ret = handleServerEvent(&event);
+                if (ret != OS_SUCCESS)
+                {
+                    return ret;
+                }
+            }
+            else
+            {
+                handleConnectionEvent(&event);
+            }
         }
 
-        // Remote socket requested to be closed only valid for clients.
-        if (event.eventMask & OS_SOCK_EV_CLOSE)
-        {
-            Debug_LOG_ERROR("OS_Socket_getPendingEvents() returned "
-                            "OS_SOCK_EV_CLOSE for handle: %d",
-                            event.socketHandle);
-            ret = OS_ERROR_CONNECTION_CLOSED;
-            break;
-        }
+        logMetricsSummary();
 
-        // Error received - print error.
-        if (event.eventMask & OS_SOCK_EV_ERROR)
+        // If the event buffer was not filled completely, there is nothing left
+        // to fetch.
+        if (numberOfSocketsWithEvents < MAX_PENDING_EVENTS)
         {
-            Debug_LOG_ERROR("OS_Socket_getPendingEvents() returned "
-                            "OS_SOCK_EV_ERROR for handle: %d, code: %d",
-                            event.socketHandle, event.currentError);
-            ret = event.currentError;
-            break;
+            return OS_SUCCESS;
         }
     }
-
-    return ret;
 }
 
 //------------------------------------------------------------------------------
@@ -179,8 +1983,21 @@ waitForIncomingConnection(
 int
 run(void)
 {
+    const uint64_t startUs = getTimeUs();
+
     Debug_LOG_INFO("Starting TLS Server...");
 
+    EventLog_init(formatEvent);
+
+    int ret = eventLog_notify_reg_callback(drainEventLog, NULL);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("eventLog_notify_reg_callback() failed, code %d", ret);
+        return -1;
+    }
+
+    mHeapStart = (uintptr_t)sbrk(0);
+
     // Check and wait until the NetworkStack component is up and running.
     OS_Error_t err = waitForNetworkStackInit(&networkStackCtx);
     if (OS_SUCCESS != err)
@@ -189,8 +2006,7 @@ run(void)
         return -1;
     }
 
-    OS_Socket_Handle_t hServer;
-    OS_Socket_Handle_t hSocket;
+    finishStartupStep(Metrics_STARTUP_NETWORK_STACK, startUs);
 
     err = OS_Socket_create(
               &networkStackCtx,
@@ -206,7 +2022,7 @@ run(void)
     const OS_Socket_Addr_t dstAddr =
     {
         .addr = OS_INADDR_ANY_STR,
-        .port = TLS_SERVER_PORT
+        .port = (uint16_t)(TLS_SERVER_PORT + worker_id)
     };
 
     err = OS_Socket_bind(
@@ -221,46 +2037,30 @@ run(void)
 
     err = OS_Socket_listen(
               hServer,
-              1);
+              TLS_SERVER_LISTEN_BACKLOG);
     if (err != OS_SUCCESS)
     {
         Debug_LOG_ERROR("OS_Socket_listen() failed, code %d", err);
         OS_Socket_close(hServer);
         return -1;
     }
+    Debug_LOG_INFO("Worker %d listening on port %u", worker_id, dstAddr.port);
 
     // -------------------------------------------------------------------------
 
+    uint64_t stepUs = getTimeUs();
+
     const OS_Crypto_Config_t cryptoCfg =
     {
         .mode = OS_Crypto_MODE_LIBRARY,
-        .entropy = IF_OS_ENTROPY_ASSIGN(
-            entropy_rpc,
-            entropy_port),
-    };
-
-    OS_Tls_Config_t tlsConfig =
-    {
-        .mode = OS_Tls_MODE_LIBRARY,
-        .library = {
-            .socket = {
-                .context    = &hSocket,
-            },
-            .flags = OS_Tls_FLAG_NONE,
-            .crypto = {
-                .policy     = NULL,
-                .caCerts    = TLS_SERVER_ROOT_CERT,
-                .ownCert    = TLS_SERVER_CERT,
-                .privateKey = TLS_SERVER_KEY,
-                .cipherSuites =
-                OS_Tls_CIPHERSUITE_FLAGS(
-                    OS_Tls_CIPHERSUITE_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
-                    OS_Tls_CIPHERSUITE_DHE_RSA_WITH_AES_128_GCM_SHA256)
-            }
-        }
+        .entropy = {
+            .read     = readEntropy,
+            .dataport = entropySource.dataport,
+        },
     };
 
-    err = OS_Crypto_init(&tlsConfig.library.crypto.handle, &cryptoCfg);
+    // All TLS contexts share the same crypto library instance.
+    err = OS_Crypto_init(&hCrypto, &cryptoCfg);
     if (OS_SUCCESS != err)
     {
         Debug_LOG_ERROR("OS_Crypto_init() failed, code %d", err);
@@ -268,187 +2068,92 @@ run(void)
     }
     Debug_LOG_INFO("Crypto library successfully initialized");
 
-    OS_Tls_Handle_t hTls;
+    stepUs = finishStartupStep(Metrics_STARTUP_CRYPTO, stepUs);
 
-    err = OS_Tls_init(&hTls, &tlsConfig);
+    initStreamPattern();
+
+    err = initConnectionPool();
     if (OS_SUCCESS != err)
     {
-        Debug_LOG_ERROR("OS_Tls_init() failed, code %d", err);
+        Debug_LOG_ERROR("initConnectionPool() failed, code %d", err);
 
         // Free previously allocated memory before return.
-        OS_Crypto_free(tlsConfig.library.crypto.handle);
+        freeConnectionPool();
+        OS_Crypto_free(hCrypto);
 
         return -1;
     }
     Debug_LOG_INFO("TLS library successfully initialized");
 
-    // -------------------------------------------------------------------------
-
-    for (;;)
-    {
-        // ---------------------------------------------------------------------
-        // Wait until a client connects
-
-        Debug_LOG_INFO( "Waiting for a remote connection..." );
-
-        OS_Socket_Addr_t srcAddr = {0};
-
-        do
-        {
-            err = waitForIncomingConnection(hServer.handleID);
-            if (err != OS_SUCCESS)
-            {
-                Debug_LOG_ERROR("waitForIncomingConnection() failed, code % d",
-                                err);
-                goto close_connection;
-            }
-
-            err = OS_Socket_accept(
-                      hServer,
-                      &hSocket,
-                      &srcAddr);
-        }
-        while (err == OS_ERROR_TRY_AGAIN);
-
-        if (err != OS_SUCCESS)
-        {
-            Debug_LOG_ERROR("OS_Socket_accept() failed, code %d", err);
-            goto close_connection;
-        }
-
-        // ---------------------------------------------------------------------
-        // Handshake
-
-        do
-        {
-            seL4_Yield();
-            err = OS_Tls_handshake(hTls);
-        }
-        while (err == OS_ERROR_WOULD_BLOCK);
-
-        if (OS_SUCCESS != err)
-        {
-            Debug_LOG_ERROR("OS_Tls_handshake() failed, code %d", err);
-            goto close_connection;
-        }
-        Debug_LOG_INFO("TLS connection established");
-
-        // ---------------------------------------------------------------------
-        // Receive request
-
-        // Require minimum 1 byte to be read before the reception is stopped.
-        const size_t cRequiredRxSize = 1;
-
-        bool stopReading = false;
-        size_t rxRemainingSize = REQUEST_MAX_SIZE;
-
-        while (!stopReading && (rxRemainingSize > 0))
-        {
-            size_t dataSize = rxRemainingSize;
-
-            err = OS_Tls_read(hTls,
-                              (mRxBuf + (REQUEST_MAX_SIZE - rxRemainingSize)),
-                              &dataSize);
-
-            switch (err)
-            {
-            case OS_SUCCESS:
-                rxRemainingSize -= dataSize;
-
-                if ((REQUEST_MAX_SIZE - rxRemainingSize) >= cRequiredRxSize)
-                {
-                    // Stop reading if the required size has been received.
-                    stopReading = true;
-                }
-                break;
-            case OS_ERROR_WOULD_BLOCK:
-                // Donate the remaining timeslice to a thread of the same
-                // priority and try to read again with the next turn.
-                seL4_Yield();
-                break;
-            case OS_ERROR_CONNECTION_CLOSED:
-                Debug_LOG_WARNING("OS_Tls_read() connection closed by network "
-                                  "stack");
-                stopReading = true;
-                break;
-            case OS_ERROR_NETWORK_CONN_SHUTDOWN:
-                Debug_LOG_WARNING("OS_Tls_read() connection reset by peer");
-                stopReading = true;
-                break;
-            default:
-                Debug_LOG_ERROR("OS_Tls_read() failed, code %d, bytes read %zu",
-                                err, (REQUEST_MAX_SIZE - rxRemainingSize));
-                goto close_connection;
-            }
-        }
+    const uint64_t readyUs =
+        finishStartupStep(Metrics_STARTUP_TLS_CONTEXTS, stepUs);
+    finishStartupStep(Metrics_STARTUP_TOTAL, startUs);
 
-        Debug_LOG_INFO("Received %zu bytes:\n%s",
-                       (REQUEST_MAX_SIZE - rxRemainingSize),
-                       mRxBuf);
+    // Tracked to catch regressions, most of it is parsing the certificates and
+    // the key for every TLS context.
+    Debug_LOG_INFO("Startup took %" PRIu64 " us (TLS contexts %" PRIu64
+                   " us)", readyUs - startUs, readyUs - stepUs);
 
-        // ---------------------------------------------------------------------
-        // Send response
+    // -------------------------------------------------------------------------
 
-        const unsigned char cTxBuf[] = HTTP_RESPONSE; // nul-terminated string
-        const size_t cTxSize = sizeof(cTxBuf);
+    // The loop only releases the lock while it waits, the ticks never see it
+    // working on a connection. It is kept after the loop has ended.
+    loopLock_lock();
 
-        size_t txRemainingSize = cTxSize;
+    TimerWheel_init(getTimeMs());
 
-        while (txRemainingSize > 0)
-        {
-            size_t dataSize = txRemainingSize;
-            err = OS_Tls_write(hTls,
-                               (cTxBuf + (cTxSize - txRemainingSize)),
-                               &dataSize);
+    ret = timeServer_notify_reg_callback(handleTimerTick, NULL);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("timeServer_notify_reg_callback() failed, code %d",
+                        ret);
+        return -1;
+    }
 
-            switch (err)
-            {
-            case OS_SUCCESS:
-                txRemainingSize -= dataSize;
-                break;
-            case OS_ERROR_WOULD_BLOCK:
-                // Donate the remaining timeslice to a thread of the same
-                // priority and try to write again with the next turn.
-                seL4_Yield();
-                break;
-            default:
-                Debug_LOG_ERROR("OS_Tls_write() failed, code %d", err);
-                goto close_connection;
-            }
-        }
+    ret = timeServer_rpc_periodic(0, TLS_SERVER_TIMER_TICK_MS * NS_PER_MS);
+    if (0 != ret)
+    {
+        Debug_LOG_ERROR("timeServer_rpc_periodic() failed, code %d", ret);
+        return -1;
+    }
 
-        Debug_LOG_INFO("Sent %zu bytes:\n%s",
-                       (cTxSize - txRemainingSize),
-                       cTxBuf);
+    Debug_LOG_INFO("Waiting for a remote connection... (max. %zu)",
+                   ARRAY_SIZE(mConnections));
 
-close_connection:
-        // ---------------------------------------------------------------------
-        // Close connection
+    for (;;)
+    {
+        err = waitAndDispatchEvents();
 
-        err = OS_Tls_reset(hTls);
-        if (OS_SUCCESS != err)
+        // All pending events are handled, so the work deferred to this point
+        // does not delay any request anymore. The event log is printed by
+        // drainEventLog() once this thread blocks again.
+        if (EventLog_hasRecords())
         {
-            Debug_LOG_ERROR("OS_Tls_reset() failed, code %d", err);
-            break;
+            eventLog_signal_emit();
         }
+        prepareFreeConnections();
 
-        err = OS_Socket_close(hSocket);
-        if (OS_SUCCESS != err)
+        if (err != OS_SUCCESS)
         {
-            Debug_LOG_ERROR("OS_Socket_close() failed, code %d", err);
+            Debug_LOG_ERROR("waitAndDispatchEvents() failed, code %d", err);
             break;
         }
-
-        Debug_LOG_INFO("TLS connection closed");
-
-        // ---------------------------------------------------------------------
     }
 
     // -------------------------------------------------------------------------
     // Free memory
 
-    OS_Crypto_free(tlsConfig.library.crypto.handle);
-    OS_Tls_free(hTls);
+    for (size_t i = 0; i < ARRAY_SIZE(mConnections); i++)
+    {
+        if (mConnections[i].state != CONNECTION_STATE_FREE)
+        {
+            closeConnection(&mConnections[i]);
+        }
+    }
+
+    OS_Socket_close(hServer);
+    freeConnectionPool();
+    OS_Crypto_free(hCrypto);
 
     return -1;
 }
@@ -23,6 +23,29 @@ IP_ADDRESS=10.0.0.1
 # netmask length in bits
 NETWORK_SIZE=24
 
+# the number of TLS server workers is fixed at build time, take it from the
+# system_config.h the demo was built with if it is found (relative to the
+# sandbox root the test environment starts in), otherwise from the environment
+# or assume a single worker
+SYSTEM_CONFIG=${SYSTEM_CONFIG:-src/demos/demo_tls_server/system_config.h}
+NUM_WORKERS=""
+if [ -f ${SYSTEM_CONFIG} ]; then
+    NUM_WORKERS=$(sed -n -E \
+        's/^#define\s+TLS_SERVER_NUM_WORKERS\s+([0-9]+).*/\1/p' \
+        ${SYSTEM_CONFIG})
+fi
+if [ -z "${NUM_WORKERS}" ]; then
+    NUM_WORKERS=${TLS_SERVER_NUM_WORKERS:-1}
+    echo "WARNING: no TLS_SERVER_NUM_WORKERS in ${SYSTEM_CONFIG}, assuming" \
+        "${NUM_WORKERS} worker(s)"
+elif [ -n "${TLS_SERVER_NUM_WORKERS:-}" ] \
+    && [ "${TLS_SERVER_NUM_WORKERS}" != "${NUM_WORKERS}" ]; then
+    echo "ERROR: TLS_SERVER_NUM_WORKERS=${TLS_SERVER_NUM_WORKERS} does not" \
+        "match ${NUM_WORKERS} in ${SYSTEM_CONFIG}"
+    exit 1
+fi
+TLS_SERVER_NUM_WORKERS=${NUM_WORKERS}
+
 # create the bridge
 sudo ip link add ${BRIDGE_NAME} type bridge
 
@@ -40,8 +63,21 @@ sudo ip link set ${BRIDGE_NAME} up
 sudo iptables -t nat -A POSTROUTING -o eth0 -j MASQUERADE
 sudo iptables -A FORWARD -i ${BRIDGE_NAME} -j ACCEPT
 
-# forward external packets through NAT
-sudo iptables -t nat -A PREROUTING -i eth0 -p tcp --dport 5560 -j DNAT  --to 10.0.0.10:5560
+# forward external packets through NAT, with several TLS server workers the
+# TCP connections are spread round robin across them, they listen on
+# consecutive ports
+if [ ${TLS_SERVER_NUM_WORKERS} -le 1 ]; then
+    sudo iptables -t nat -A PREROUTING -i eth0 -p tcp --dport 5560 -j DNAT  --to 10.0.0.10:5560
+else
+    for ((i = 0; i < TLS_SERVER_NUM_WORKERS; i++)); do
+        # the nat table only sees the first packet of a connection, rule i
+        # takes every (N - i)-th of the connections left over by the previous
+        # rules
+        sudo iptables -t nat -A PREROUTING -i eth0 -p tcp --dport 5560 \
+            -m statistic --mode nth --every $((TLS_SERVER_NUM_WORKERS - i)) \
+            --packet 0 -j DNAT --to 10.0.0.10:$((5560 + i))
+    done
+fi
 sudo iptables -t nat -A PREROUTING -i eth0 -p udp --dport 5560 -j DNAT  --to 10.0.0.10:5560
 
 # forward packets to the internal bridge through NAT to the docker bridge
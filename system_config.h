@@ -47,6 +47,12 @@
 #define CHANMUX_CHANNEL_NIC_CTRL 4
 #define CHANMUX_CHANNEL_NIC_DATA 5
 
+// FIFO of the data channel of a NIC, it holds the frames received from the
+// UART until the NIC driver reads them. It is big enough to store 1 minute of
+// network "background" traffic. Value found by manual testing, may differ in
+// less noisy networks. PAGE_SIZE is taken from where the FIFO is defined.
+#define CHANMUX_NIC_DATA_FIFO_SIZE  (1024 * PAGE_SIZE)
+
 
 //-----------------------------------------------------------------------------
 // ChanMUX client
@@ -59,11 +65,107 @@
 //-----------------------------------------------------------------------------
 #define TLS_SERVER_PORT             5560
 
+// Number of TlsServer instances (1 to 4), each one with its own TLS contexts,
+// entropy source and connection slots. picoTCP cannot share a listening socket
+// between clients, so worker i listens on TLS_SERVER_PORT + i and the host
+// spreads the connections to TLS_SERVER_PORT across them (see
+// docker/entrypoint.sh). All limits below apply per worker.
+#define TLS_SERVER_NUM_WORKERS      1
+
+// Number of connections that are served in parallel, each one holds a socket
+// and a TLS context.
+#define TLS_SERVER_MAX_CONNECTIONS  16
+
+// Connections waiting to be accepted by the listening socket.
+#define TLS_SERVER_LISTEN_BACKLOG   TLS_SERVER_MAX_CONNECTIONS
+
+// Admission control, applied right after accept and before any crypto work.
+// Connections beyond the limits are closed again, as are connections finding
+// all slots busy if TLS_SERVER_REJECT_WHEN_FULL is set; otherwise those wait in
+// the backlog until a slot is freed. The per-client limit is keyed on the
+// source address, benchmarks from a single host need it at the maximum.
+#define TLS_SERVER_MAX_HANDSHAKES           8
+#define TLS_SERVER_MAX_CONNECTIONS_PER_PEER TLS_SERVER_MAX_CONNECTIONS
+#define TLS_SERVER_REJECT_WHEN_FULL         true
+
+// One socket per connection plus the listening socket.
+#define TLS_SERVER_NUM_SOCKETS      (TLS_SERVER_MAX_CONNECTIONS + 1)
+
+// Every connection allocates its own TLS context (including the mbedTLS record
+// buffers) on the heap.
+#define TLS_SERVER_HEAP_SIZE        (4 * 1024 * 1024)
+
+// Cipher suites offered to clients (see OS_Tls_CipherSuite_t). ECDHE is much
+// cheaper than DHE for the server, handshake_bench.sh measures both.
+#define TLS_SERVER_CIPHER_SUITES \
+    OS_Tls_CIPHERSUITE_FLAGS( \
+        OS_Tls_CIPHERSUITE_ECDHE_RSA_WITH_AES_128_GCM_SHA256, \
+        OS_Tls_CIPHERSUITE_DHE_RSA_WITH_AES_128_GCM_SHA256)
+
+// Persistent HTTP connections are closed after being idle for the timeout or
+// after serving the maximum number of requests.
+#define TLS_SERVER_KEEP_ALIVE_TIMEOUT_MS    5000
+#define TLS_SERVER_KEEP_ALIVE_MAX_REQUESTS  100
+
+// Deadlines of the phases of a connection, a connection that misses one is
+// closed to free its slot. The handshake is limited from accept, the request
+// from its first byte and the response while no data can be sent.
+#define TLS_SERVER_HANDSHAKE_TIMEOUT_MS     10000
+#define TLS_SERVER_FIRST_BYTE_TIMEOUT_MS    10000
+#define TLS_SERVER_REQUEST_TIMEOUT_MS       10000
+#define TLS_SERVER_RESPONSE_TIMEOUT_MS      10000
+
+// Deadlines are kept in a timer wheel of this many slots (a power of two) of
+// one tick each. A periodic timer of the TimeServer advances it every tick.
+#define TLS_SERVER_TIMER_TICK_MS            100
+#define TLS_SERVER_TIMER_WHEEL_SIZE         128
+
+// Request bodies are accepted up to this size, but not processed.
+#define TLS_SERVER_REQUEST_BODY_MAX_SIZE    (1024 * 1024)
+
+// Interval of the latency and traffic summary in the log.
+#define TLS_SERVER_METRICS_INTERVAL_MS      (60 * 1000)
+
+// Buffer for the page served at /metrics, a page that does not fit is answered
+// with 500. It holds the page with every value at its maximum width.
+#define TLS_SERVER_METRICS_PAGE_SIZE        (16 * 1024)
+
+// Maximum payload of a TLS record (MBEDTLS_SSL_OUT_CONTENT_LEN), streamed
+// bodies are written in chunks of this size to fill every record.
+#define TLS_SERVER_TX_RECORD_SIZE           16384
+
+// Response headers are sent in one record together with the start of the body
+// up to this size.
+#define TLS_SERVER_TX_GATHER_SIZE           1024
+
+// Largest body generated by the /download/<bytes> endpoint.
+#define TLS_SERVER_DOWNLOAD_MAX_SIZE        (256 * 1024 * 1024)
+
+// Connection events are logged through a ring buffer of this many records
+// (a power of two), which is printed when the server is idle.
+#define TLS_SERVER_EVENT_LOG_SIZE           256
+
+// Priority of the thread that prints the event log. It is below the default
+// priority (254) of all other threads, so printing never preempts a request.
+#define TLS_SERVER_EVENT_LOG_PRIORITY       100
+
+// Records per second and event, further ones are dropped and counted. Keeps a
+// flood of failing handshakes from saturating the serial console.
+#define TLS_SERVER_EVENT_LOG_RATE_LIMIT     20
+
+// Allocations of the TLS library while a connection is processed (handshake
+// state, peer certificate, session keys) are served from an arena per
+// connection slot of this size, larger ones and those of a full arena fall back
+// to the heap. About 37 KiB were used by ECDHE handshakes on the host build,
+// see tls_server_arena_high_water_bytes at /metrics.
+#define TLS_SERVER_CONNECTION_ARENA_SIZE    (48 * 1024)
+
 
 //-----------------------------------------------------------------------------
 // Network Stack
 //-----------------------------------------------------------------------------
-#define NETWORK_STACK_NUM_SOCKETS   2
+#define NETWORK_STACK_NUM_SOCKETS   \
+    (TLS_SERVER_NUM_SOCKETS * TLS_SERVER_NUM_WORKERS)
 #define ETH_ADDR                    "10.0.0.10"
 #define ETH_GATEWAY_ADDR            "10.0.0.1"
 #define ETH_SUBNET_MASK             "255.255.255.0"
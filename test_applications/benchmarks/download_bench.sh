@@ -0,0 +1,102 @@
+#!/bin/bash -eu
+
+#-------------------------------------------------------------------------------
+#
+# Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+# 
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+# Measure the download throughput of the demo TLS server.
+#-------------------------------------------------------------------------------
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" >/dev/null 2>&1 && pwd)"
+
+#-------------------------------------------------------------------------------
+function print_usage_help()
+{
+    echo "Usage: $(basename $0) [-h|-s <server>|-r <runs>] [<size>...]"
+    echo "  -h : Show usage info (optional)."
+    echo "  -s : Server address and port (optional, default 172.17.0.1:5560)."
+    echo "  -r : Downloads per size (optional, default 3)."
+    echo "  size : Body sizes in bytes (optional, default 1 MiB, 16 MiB, 128 MiB)."
+}
+
+#-------------------------------------------------------------------------------
+function print_err()
+{
+    local MSG=$1
+    echo "ERROR: ${MSG}" >&2
+}
+
+#-------------------------------------------------------------------------------
+# Arguments
+#-------------------------------------------------------------------------------
+
+SERVER="172.17.0.1:5560"
+RUNS=3
+
+while getopts ":hs:r:" ARG; do
+    case "${ARG}" in
+        h)
+            print_usage_help
+            exit 0
+            ;;
+        s)
+            SERVER=${OPTARG}
+            ;;
+        r)
+            RUNS=${OPTARG}
+            ;;
+        \?)
+            print_err "invalid parameter ${OPTARG}"
+            print_usage_help
+            exit 1
+            ;;
+        :)
+            print_err "incomplete parameter ${OPTARG}"
+            print_usage_help
+            exit 1
+            ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+SIZES=("$@")
+if [ ${#SIZES[@]} -eq 0 ]; then
+    SIZES=($((1024 * 1024)) $((16 * 1024 * 1024)) $((128 * 1024 * 1024)))
+fi
+
+#-------------------------------------------------------------------------------
+# Download
+#-------------------------------------------------------------------------------
+
+cd ${SCRIPT_DIR}/..
+
+printf "%12s %4s %12s %10s %10s\n" "bytes" "run" "received" "seconds" "MiB/s"
+
+for SIZE in "${SIZES[@]}"
+do
+    for RUN in $(seq 1 ${RUNS})
+    do
+        # The body is generated by the server (see /download/<bytes>), the
+        # time includes the TLS handshake.
+        RESULT=$(curl --silent --show-error --output /dev/null \
+            --cacert certs/CA.crt --cert certs/client.crt \
+            --key certs/client.key \
+            --write-out "%{size_download} %{time_total}" \
+            https://${SERVER}/download/${SIZE})
+
+        read RECEIVED TIME_TOTAL <<< "${RESULT}"
+
+        if [ "${RECEIVED}" != "${SIZE}" ]; then
+            print_err "received ${RECEIVED} of ${SIZE} bytes"
+            exit 1
+        fi
+
+        awk -v s=${SIZE} -v r=${RUN} -v n=${RECEIVED} -v t=${TIME_TOTAL} \
+            'BEGIN { printf "%12d %4d %12d %10.3f %10.2f\n", s, r, n, t,
+                     n / 1048576 / t }'
+    done
+done
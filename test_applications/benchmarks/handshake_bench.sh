@@ -0,0 +1,102 @@
+#!/bin/bash -eu
+
+#-------------------------------------------------------------------------------
+#
+# Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+# 
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+# Measure the full TLS handshakes per second of the demo TLS server for each
+# cipher suite.
+#-------------------------------------------------------------------------------
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" >/dev/null 2>&1 && pwd)"
+
+#-------------------------------------------------------------------------------
+function print_usage_help()
+{
+    echo "Usage: $(basename $0) [-h|-s <server>|-t <seconds>] [<cipher>...]"
+    echo "  -h : Show usage info (optional)."
+    echo "  -s : Server address and port (optional, default 172.17.0.1:5560)."
+    echo "  -t : Seconds per cipher suite (optional, default 30)."
+    echo "  cipher : OpenSSL cipher suite names (optional, default all suites"
+    echo "           offered by the TLS server)."
+}
+
+#-------------------------------------------------------------------------------
+function print_err()
+{
+    local MSG=$1
+    echo "ERROR: ${MSG}" >&2
+}
+
+#-------------------------------------------------------------------------------
+# Arguments
+#-------------------------------------------------------------------------------
+
+SERVER="172.17.0.1:5560"
+SECONDS_PER_CIPHER=30
+
+while getopts ":hs:t:" ARG; do
+    case "${ARG}" in
+        h)
+            print_usage_help
+            exit 0
+            ;;
+        s)
+            SERVER=${OPTARG}
+            ;;
+        t)
+            SECONDS_PER_CIPHER=${OPTARG}
+            ;;
+        \?)
+            print_err "invalid parameter ${OPTARG}"
+            print_usage_help
+            exit 1
+            ;;
+        :)
+            print_err "incomplete parameter ${OPTARG}"
+            print_usage_help
+            exit 1
+            ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+CIPHERS=("$@")
+if [ ${#CIPHERS[@]} -eq 0 ]; then
+    CIPHERS=(ECDHE-RSA-AES128-GCM-SHA256 DHE-RSA-AES128-GCM-SHA256)
+fi
+
+#-------------------------------------------------------------------------------
+# Handshakes
+#-------------------------------------------------------------------------------
+
+cd ${SCRIPT_DIR}/..
+
+printf "%-32s %12s %10s %14s\n" "cipher" "handshakes" "seconds" "handshakes/s"
+
+for CIPHER in "${CIPHERS[@]}"
+do
+    # Every connection performs a full handshake including client
+    # authentication, no data is transferred.
+    RESULT=$(openssl s_time -tls1_2 -new -time ${SECONDS_PER_CIPHER} \
+        -CAfile certs/CA.crt -cert certs/client.crt -key certs/client.key \
+        -connect ${SERVER} -cipher ${CIPHER} 2>&1 || true)
+
+    # "<n> connections in <t> real seconds, ..."
+    if [[ ! "${RESULT}" =~ ([0-9]+)\ connections\ in\ ([0-9]+)\ real\ seconds ]]
+    then
+        print_err "no handshake with ${CIPHER}"
+        printf "%-32s %12s %10s %14s\n" ${CIPHER} "-" "-" "-"
+        continue
+    fi
+
+    HANDSHAKES=${BASH_REMATCH[1]}
+    REAL_SECONDS=${BASH_REMATCH[2]}
+
+    awk -v c=${CIPHER} -v n=${HANDSHAKES} -v t=${REAL_SECONDS} \
+        'BEGIN { printf "%-32s %12d %10d %14.2f\n", c, n, t, n / t }'
+done
@@ -0,0 +1,203 @@
+/*
+ * Microbenchmark of the HTTP request parser of the TLS server
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+#include "HttpParser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//------------------------------------------------------------------------------
+
+// Same limit as REQUEST_MAX_SIZE in TlsServer.c.
+#define MAX_HEADER_SIZE 1024
+
+#define DEFAULT_DURATION_SEC 1.0
+
+typedef struct
+{
+    const char* name;
+    const char* request;
+}
+Sample_t;
+
+static const Sample_t samples[] =
+{
+    {
+        "curl",
+        "GET /index.html HTTP/1.1\r\n"
+        "Host: 172.17.0.1:5560\r\n"
+        "User-Agent: curl/7.88.1\r\n"
+        "Accept: */*\r\n"
+        "\r\n"
+    },
+    {
+        "browser",
+        "GET /index.html HTTP/1.1\r\n"
+        "Host: 172.17.0.1:5560\r\n"
+        "Connection: keep-alive\r\n"
+        "Cache-Control: max-age=0\r\n"
+        "sec-ch-ua: \"Chromium\";v=\"118\", \"Not=A?Brand\";v=\"99\"\r\n"
+        "sec-ch-ua-mobile: ?0\r\n"
+        "sec-ch-ua-platform: \"Linux\"\r\n"
+        "Upgrade-Insecure-Requests: 1\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+        "(KHTML, like Gecko) Chrome/118.0.0.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+        "image/avif,image/webp,*/*;q=0.8\r\n"
+        "Sec-Fetch-Site: none\r\n"
+        "Sec-Fetch-Mode: navigate\r\n"
+        "Sec-Fetch-User: ?1\r\n"
+        "Sec-Fetch-Dest: document\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: en-US,en;q=0.9,de;q=0.8\r\n"
+        "If-None-Match: \"5d8c72a5edda8d6a\"\r\n"
+        "\r\n"
+    },
+    {
+        "post",
+        "POST /upload HTTP/1.1\r\n"
+        "Host: 172.17.0.1:5560\r\n"
+        "Content-Type: application/json\r\n"
+        "Content-Length: 16\r\n"
+        "\r\n"
+        "{\"status\":\"ok\"} "
+    },
+};
+
+//------------------------------------------------------------------------------
+
+static double
+getTimeSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+// Parse a request that arrives in fragments of the given size, chunk 0 feeds
+// the whole request at once.
+static size_t
+parseRequest(
+    HttpParser_t* const parser,
+    const char* const   request,
+    const size_t        len,
+    const size_t        chunk)
+{
+    size_t available = (0 == chunk) ? len : 0;
+
+    HttpParser_init(parser, MAX_HEADER_SIZE, len);
+
+    for (;;)
+    {
+        if (0 != chunk)
+        {
+            available = (available + chunk < len) ? (available + chunk) : len;
+        }
+
+        HttpParser_Result_t result =
+            HttpParser_parseHeader(parser, request, available);
+
+        if (HttpParser_RESULT_COMPLETE == result)
+        {
+            size_t consumed = parser->headerSize
+                              + HttpParser_consumeBody(
+                                  parser,
+                                  available - parser->headerSize);
+
+            // The body keeps arriving in fragments.
+            while (consumed < len)
+            {
+                const size_t size = (chunk < len - consumed) ?
+                                    chunk : (len - consumed);
+                consumed += HttpParser_consumeBody(parser, size);
+            }
+
+            return consumed;
+        }
+        if ((HttpParser_RESULT_ERROR == result) || (available == len))
+        {
+            fprintf(stderr, "ERROR: parsing failed, status %u\n",
+                    parser->status);
+            exit(1);
+        }
+    }
+}
+
+static void
+runSample(
+    const Sample_t* const sample,
+    const size_t          chunk,
+    const double          duration)
+{
+    const size_t len = strlen(sample->request);
+    HttpParser_t parser;
+    unsigned long long iterations = 0;
+    size_t consumed = 0;
+
+    const double start = getTimeSec();
+    double elapsed;
+
+    do
+    {
+        // Check the clock only every now and then to keep it out of the
+        // measurement.
+        for (unsigned int i = 0; i < 1000; i++)
+        {
+            consumed += parseRequest(&parser, sample->request, len, chunk);
+        }
+        iterations += 1000;
+        elapsed = getTimeSec() - start;
+    }
+    while (elapsed < duration);
+
+    if (consumed != (iterations * len))
+    {
+        fprintf(stderr, "ERROR: %s consumed %zu of %llu bytes\n",
+                sample->name, consumed, iterations * len);
+        exit(1);
+    }
+
+    printf("%-8s %5zu bytes  chunk %5zu  %10.1f MB/s  %10.0f req/s\n",
+           sample->name,
+           len,
+           (0 == chunk) ? len : chunk,
+           ((double)consumed / elapsed) / 1e6,
+           (double)iterations / elapsed);
+}
+
+//------------------------------------------------------------------------------
+
+int
+main(
+    int   argc,
+    char* argv[])
+{
+    static const size_t chunks[] = { 0, 64, 16 };
+
+    const double duration = (argc > 1) ? atof(argv[1]) : DEFAULT_DURATION_SEC;
+
+    if (duration <= 0)
+    {
+        fprintf(stderr, "Usage: %s [<seconds per run>]\n", argv[0]);
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+        for (size_t j = 0; j < sizeof(chunks) / sizeof(chunks[0]); j++)
+        {
+            runSample(&samples[i], chunks[j], duration);
+        }
+    }
+
+    return 0;
+}
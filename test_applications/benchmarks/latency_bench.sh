@@ -0,0 +1,137 @@
+#!/bin/bash -eu
+
+#-------------------------------------------------------------------------------
+#
+# Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+# 
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+# Measure the time to first byte of new connections of TLS 1.2 and TLS 1.3
+# clients to the demo TLS server under added network latency.
+#-------------------------------------------------------------------------------
+
+#-------------------------------------------------------------------------------
+function print_usage_help()
+{
+    echo "Usage: $(basename $0) [-h|-s <server>|-i <interface>|-l <build dir>"
+    echo "       |-t <seconds>|-v] [<delay ms>...]"
+    echo "  -h : Show usage info (optional)."
+    echo "  -s : Server address and port (optional, default 172.17.0.1:5560)."
+    echo "  -i : Network interface towards the server, the delay is added to"
+    echo "       its outgoing packets (optional, default docker0)."
+    echo "  -l : Build directory of the benchmarks (optional, default"
+    echo "       build-benchmarks)."
+    echo "  -t : Seconds per run (optional, default 10)."
+    echo "  -v : Verify the server certificate (optional, the demo certificates"
+    echo "       have expired)."
+    echo "  delay ms : Added one-way delays (optional, default 0 25 100)."
+    echo
+    echo "  Adding the delay needs root, tc and the netem queueing discipline."
+}
+
+#-------------------------------------------------------------------------------
+function print_err()
+{
+    local MSG=$1
+    echo "ERROR: ${MSG}" >&2
+}
+
+#-------------------------------------------------------------------------------
+function remove_delay()
+{
+    sudo tc qdisc del dev ${INTERFACE} root 2>/dev/null || true
+}
+
+#-------------------------------------------------------------------------------
+# Arguments
+#-------------------------------------------------------------------------------
+
+SERVER="172.17.0.1:5560"
+INTERFACE="docker0"
+BENCH_BUILD_DIR="build-benchmarks"
+SECONDS_PER_RUN=10
+LOAD_GEN_ARGS=()
+
+while getopts ":hs:i:l:t:v" ARG; do
+    case "${ARG}" in
+        h)
+            print_usage_help
+            exit 0
+            ;;
+        s)
+            SERVER=${OPTARG}
+            ;;
+        i)
+            INTERFACE=${OPTARG}
+            ;;
+        l)
+            BENCH_BUILD_DIR=${OPTARG}
+            ;;
+        t)
+            SECONDS_PER_RUN=${OPTARG}
+            ;;
+        v)
+            LOAD_GEN_ARGS+=(-v)
+            ;;
+        \?)
+            print_err "invalid parameter ${OPTARG}"
+            print_usage_help
+            exit 1
+            ;;
+        :)
+            print_err "incomplete parameter ${OPTARG}"
+            print_usage_help
+            exit 1
+            ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+DELAYS=("$@")
+if [ ${#DELAYS[@]} -eq 0 ]; then
+    DELAYS=(0 25 100)
+fi
+
+LOAD_GEN=${BENCH_BUILD_DIR}/tls_load_gen
+if [ ! -x ${LOAD_GEN} ]; then
+    print_err "${LOAD_GEN} not found, see README.md"
+    exit 1
+fi
+
+#-------------------------------------------------------------------------------
+# Time to first byte
+#-------------------------------------------------------------------------------
+
+trap remove_delay EXIT
+
+printf "%-9s %-8s %10s %10s %10s %10s %8s\n" "delay ms" "client" "tls1.3" \
+    "ttfb p50" "ttfb p99" "handshake" "errors"
+
+for DELAY in "${DELAYS[@]}"
+do
+    remove_delay
+    if [ ${DELAY} -gt 0 ]; then
+        sudo tc qdisc add dev ${INTERFACE} root netem delay ${DELAY}ms
+    fi
+
+    for VERSION in 1.2 1.3
+    do
+        # One client opening a new connection for every request, so every
+        # sample contains the TCP and the full TLS handshake.
+        RESULT=$(${LOAD_GEN} -s ${SERVER} -c 1 -r 1 -V ${VERSION} \
+            -d ${SECONDS_PER_RUN} ${LOAD_GEN_ARGS[@]+"${LOAD_GEN_ARGS[@]}"} \
+            2>/dev/null)
+
+        # Pick the numbers from the JSON result, one value per line.
+        echo "${RESULT}" | awk -v d=${DELAY} -v v=TLS${VERSION} -F '[:,]' '
+            /"handshakes"/        { n = $2 }
+            /"tls1_3_handshakes"/ { n13 = $2 }
+            /"handshake_ms"/      { h = $3 }
+            /"ttfb_ms"/           { p50 = $3; p99 = $7 }
+            /_errors"/            { e += $2 }
+            END { printf "%-9d %-8s %10s %10.1f %10.1f %10.1f %8d\n",
+                  d, v, (n13 + 0) "/" (n + 0), p50, p99, h, e }'
+    done
+done
@@ -0,0 +1,810 @@
+/*
+ * Load generator for the demo TLS server
+ *
+ * Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+ * 
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * For commercial licensing, contact: info.cyber@hensoldt.net
+ */
+
+// strcasestr()
+#define _GNU_SOURCE
+
+#include <openssl/err.h>
+#include <openssl/ssl.h>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+
+#define DEFAULT_SERVER      "172.17.0.1:5560"
+#define DEFAULT_PATH        "/"
+#define DEFAULT_CLIENTS     4
+#define DEFAULT_DURATION    10
+#define DEFAULT_REQUESTS    100
+
+// Covers the response headers of the TLS server, the body is read in chunks.
+#define RESPONSE_HEADER_MAX_SIZE 1024
+
+#define SOCKET_TIMEOUT_SEC  10
+
+#define MAX_CIPHERS 16
+
+typedef struct
+{
+    const char*  host;
+    const char*  port;
+    const char*  path;
+    const char*  certsDir;
+    const char*  cipher;
+    // Highest TLS version offered, TLS 1.2 is the lowest in any case.
+    int          maxVersion;
+    unsigned int numClients;
+    // Clients are spread over this many consecutive ports, one per worker.
+    unsigned int numWorkers;
+    unsigned int duration;
+    // Requests per connection, 1 closes the connection after each request.
+    unsigned int requestsPerConnection;
+    bool         isResume;
+    bool         isVerify;
+}
+Config_t;
+
+// Latencies in microseconds, grown as needed.
+typedef struct
+{
+    unsigned long* values;
+    size_t         len;
+    size_t         capacity;
+}
+Samples_t;
+
+typedef struct
+{
+    unsigned long connectErrors;
+    unsigned long handshakeErrors;
+    unsigned long requestErrors;
+    unsigned long handshakes;
+    unsigned long resumed;
+    unsigned long tls13;
+    unsigned long requests;
+    unsigned long long bytes;
+    Samples_t     handshakeUs;
+    Samples_t     requestUs;
+    // From the start of the TCP connect to the first byte of the first
+    // response, the latency a user sees when opening a page.
+    Samples_t     ttfbUs;
+}
+Results_t;
+
+typedef struct
+{
+    pthread_t       thread;
+    const Config_t* config;
+    // Port of the worker this client connects to.
+    char            port[8];
+    SSL_CTX*        ctx;
+    double          deadline;
+    // Start of the current connection, 0 once its first byte was received.
+    double          connectStart;
+    Results_t       results;
+}
+Client_t;
+
+//------------------------------------------------------------------------------
+
+static double
+getTimeSec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+static unsigned long
+getElapsedUs(
+    const double start)
+{
+    return (unsigned long)((getTimeSec() - start) * 1e6);
+}
+
+static void
+addSample(
+    Samples_t* const    samples,
+    const unsigned long value)
+{
+    if (samples->len == samples->capacity)
+    {
+        samples->capacity = (0 == samples->capacity) ?
+                            1024 : (samples->capacity * 2);
+        samples->values = realloc(samples->values,
+                                  samples->capacity * sizeof(unsigned long));
+        if (NULL == samples->values)
+        {
+            fprintf(stderr, "ERROR: out of memory\n");
+            exit(1);
+        }
+    }
+
+    samples->values[samples->len++] = value;
+}
+
+static void
+mergeSamples(
+    Samples_t* const       dst,
+    const Samples_t* const src)
+{
+    for (size_t i = 0; i < src->len; i++)
+    {
+        addSample(dst, src->values[i]);
+    }
+}
+
+static int
+compareSamples(
+    const void* a,
+    const void* b)
+{
+    const unsigned long x = *(const unsigned long*)a;
+    const unsigned long y = *(const unsigned long*)b;
+
+    return (x > y) - (x < y);
+}
+
+// Samples must be sorted.
+static double
+getPercentileMs(
+    const Samples_t* const samples,
+    const unsigned int     percent)
+{
+    if (0 == samples->len)
+    {
+        return 0;
+    }
+
+    size_t rank = ((samples->len * percent) + 99) / 100;
+    if (rank > 0)
+    {
+        rank--;
+    }
+
+    return (double)samples->values[rank] / 1000.0;
+}
+
+//------------------------------------------------------------------------------
+
+static int
+connectToServer(
+    const Config_t* const config,
+    const char* const     port)
+{
+    struct addrinfo hints =
+    {
+        .ai_family   = AF_UNSPEC,
+        .ai_socktype = SOCK_STREAM,
+    };
+    struct addrinfo* list;
+
+    if (0 != getaddrinfo(config->host, port, &hints, &list))
+    {
+        return -1;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* ai = list; ai != NULL; ai = ai->ai_next)
+    {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        // Do not let a stuck connection block a client forever.
+        const struct timeval timeout = { .tv_sec = SOCKET_TIMEOUT_SEC };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        // Requests are small, do not let Nagle delay them.
+        const int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        if (0 == connect(fd, ai->ai_addr, ai->ai_addrlen))
+        {
+            break;
+        }
+
+        close(fd);
+        fd = -1;
+    }
+
+    freeaddrinfo(list);
+
+    return fd;
+}
+
+// Send a request and read the complete response. Returns false on any error,
+// isOpen tells if the connection can be used for another request.
+static bool
+sendRequest(
+    Client_t* const client,
+    SSL* const      ssl,
+    const bool      isLast,
+    bool* const     isOpen)
+{
+    const Config_t* const config = client->config;
+    char buf[RESPONSE_HEADER_MAX_SIZE + 1];
+
+    const int len = snprintf(buf, sizeof(buf),
+                             "GET %s HTTP/1.1\r\n"
+                             "Host: %s:%s\r\n"
+                             "Connection: %s\r\n"
+                             "\r\n",
+                             config->path,
+                             config->host,
+                             client->port,
+                             isLast ? "close" : "keep-alive");
+
+    *isOpen = false;
+
+    if (SSL_write(ssl, buf, len) != len)
+    {
+        return false;
+    }
+
+    // Read until the end of the header.
+    size_t size = 0;
+    char* body = NULL;
+    while (NULL == body)
+    {
+        if (size == RESPONSE_HEADER_MAX_SIZE)
+        {
+            return false;
+        }
+
+        const int ret = SSL_read(ssl, buf + size,
+                                 (int)(RESPONSE_HEADER_MAX_SIZE - size));
+        if (ret <= 0)
+        {
+            return false;
+        }
+        size += (size_t)ret;
+        buf[size] = '\0';
+
+        if (client->connectStart > 0)
+        {
+            addSample(&client->results.ttfbUs,
+                      getElapsedUs(client->connectStart));
+            client->connectStart = 0;
+        }
+
+        body = strstr(buf, "\r\n\r\n");
+    }
+    body += 4;
+
+    unsigned int status = 0;
+    if ((1 != sscanf(buf, "HTTP/1.%*u %u", &status))
+        || (status < 200) || (status >= 400))
+    {
+        return false;
+    }
+
+    // Without a Content-Length the body ends with the connection.
+    long long remaining = -1;
+    const char* header = strcasestr(buf, "\r\nContent-Length:");
+    if ((NULL != header) && (header < body))
+    {
+        remaining = atoll(header + strlen("\r\nContent-Length:"));
+    }
+    const bool isClose = (NULL != strcasestr(buf, "\r\nConnection: close"));
+
+    const size_t bodyReceived = size - (size_t)(body - buf);
+    client->results.bytes += bodyReceived;
+    if (remaining >= 0)
+    {
+        remaining -= (long long)bodyReceived;
+    }
+
+    while (remaining != 0)
+    {
+        const int ret = SSL_read(ssl, buf, sizeof(buf));
+        if (ret <= 0)
+        {
+            // Only fine if the length was not known.
+            return (remaining < 0);
+        }
+        client->results.bytes += (unsigned long long)ret;
+        if (remaining > 0)
+        {
+            remaining -= ret;
+        }
+    }
+
+    *isOpen = !isClose;
+
+    return true;
+}
+
+// Open a connection, send requests on it and close it again.
+static void
+runConnection(
+    Client_t* const      client,
+    SSL_SESSION** const  session)
+{
+    const Config_t* const config = client->config;
+    Results_t* const results = &client->results;
+
+    client->connectStart = getTimeSec();
+
+    const int fd = connectToServer(config, client->port);
+    if (fd < 0)
+    {
+        results->connectErrors++;
+        // Do not hammer a server that is not there.
+        usleep(100 * 1000);
+        return;
+    }
+
+    SSL* ssl = SSL_new(client->ctx);
+    SSL_set_fd(ssl, fd);
+    if (config->isResume && (NULL != *session))
+    {
+        SSL_set_session(ssl, *session);
+    }
+
+    const double start = getTimeSec();
+    if (SSL_connect(ssl) != 1)
+    {
+        // Report the reason once per client, the queue has to be cleared in
+        // any case.
+        if (0 == results->handshakeErrors++)
+        {
+            ERR_print_errors_fp(stderr);
+        }
+        ERR_clear_error();
+        SSL_free(ssl);
+        close(fd);
+        return;
+    }
+    addSample(&results->handshakeUs, getElapsedUs(start));
+    results->handshakes++;
+
+    if (SSL_session_reused(ssl))
+    {
+        results->resumed++;
+    }
+    if (TLS1_3_VERSION == SSL_version(ssl))
+    {
+        results->tls13++;
+    }
+    if (config->isResume)
+    {
+        SSL_SESSION_free(*session);
+        *session = SSL_get1_session(ssl);
+    }
+
+    bool isOpen = true;
+    for (unsigned int i = 0;
+         isOpen && (i < config->requestsPerConnection)
+         && (getTimeSec() < client->deadline);
+         i++)
+    {
+        const double requestStart = getTimeSec();
+        const bool isLast = (i + 1 == config->requestsPerConnection);
+
+        if (!sendRequest(client, ssl, isLast, &isOpen))
+        {
+            results->requestErrors++;
+            break;
+        }
+        addSample(&results->requestUs, getElapsedUs(requestStart));
+        results->requests++;
+    }
+
+    SSL_shutdown(ssl);
+    SSL_free(ssl);
+    close(fd);
+}
+
+static void*
+runClient(
+    void* arg)
+{
+    Client_t* const client = arg;
+    SSL_SESSION* session = NULL;
+
+    while (getTimeSec() < client->deadline)
+    {
+        runConnection(client, &session);
+    }
+
+    SSL_SESSION_free(session);
+
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+
+static SSL_CTX*
+createContext(
+    const Config_t* const config)
+{
+    char ca[512], cert[512], key[512];
+
+    snprintf(ca, sizeof(ca), "%s/CA.crt", config->certsDir);
+    snprintf(cert, sizeof(cert), "%s/client.crt", config->certsDir);
+    snprintf(key, sizeof(key), "%s/client.key", config->certsDir);
+
+    SSL_CTX* ctx = SSL_CTX_new(TLS_client_method());
+    if (NULL == ctx)
+    {
+        return NULL;
+    }
+
+    // The TLS server only implements TLS 1.2, a client offering TLS 1.3 as
+    // well shows the cost of the fallback.
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_max_proto_version(ctx, config->maxVersion);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT);
+
+    if (((NULL != config->cipher)
+         && (1 != SSL_CTX_set_cipher_list(ctx, config->cipher)))
+        || (1 != SSL_CTX_load_verify_locations(ctx, ca, NULL))
+        || (1 != SSL_CTX_use_certificate_file(ctx, cert, SSL_FILETYPE_PEM))
+        || (1 != SSL_CTX_use_PrivateKey_file(ctx, key, SSL_FILETYPE_PEM)))
+    {
+        ERR_print_errors_fp(stderr);
+        SSL_CTX_free(ctx);
+        return NULL;
+    }
+
+    SSL_CTX_set_verify(ctx,
+                       config->isVerify ? SSL_VERIFY_PEER : SSL_VERIFY_NONE,
+                       NULL);
+
+    return ctx;
+}
+
+static void
+writeLatency(
+    FILE* const            out,
+    const char* const      name,
+    const Samples_t* const samples)
+{
+    fprintf(out,
+            "      \"%s\": { \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+            "\"max\": %.3f }",
+            name,
+            getPercentileMs(samples, 50),
+            getPercentileMs(samples, 90),
+            getPercentileMs(samples, 99),
+            getPercentileMs(samples, 100));
+}
+
+static void
+writeResult(
+    FILE* const            out,
+    const Config_t* const  config,
+    const Results_t* const results,
+    const double           elapsed)
+{
+    fprintf(out,
+            "    {\n"
+            "      \"cipher\": \"%s\",\n"
+            "      \"clients\": %u,\n"
+            "      \"workers\": %u,\n"
+            "      \"requests_per_connection\": %u,\n"
+            "      \"resume\": %s,\n"
+            "      \"seconds\": %.3f,\n"
+            "      \"handshakes\": %lu,\n"
+            "      \"resumed\": %lu,\n"
+            "      \"tls1_3_handshakes\": %lu,\n"
+            "      \"requests\": %lu,\n"
+            "      \"bytes\": %llu,\n"
+            "      \"connect_errors\": %lu,\n"
+            "      \"handshake_errors\": %lu,\n"
+            "      \"request_errors\": %lu,\n"
+            "      \"handshakes_per_sec\": %.2f,\n"
+            "      \"requests_per_sec\": %.2f,\n",
+            (NULL != config->cipher) ? config->cipher : "default",
+            config->numClients,
+            config->numWorkers,
+            config->requestsPerConnection,
+            config->isResume ? "true" : "false",
+            elapsed,
+            results->handshakes,
+            results->resumed,
+            results->tls13,
+            results->requests,
+            results->bytes,
+            results->connectErrors,
+            results->handshakeErrors,
+            results->requestErrors,
+            (double)results->handshakes / elapsed,
+            (double)results->requests / elapsed);
+    writeLatency(out, "handshake_ms", &results->handshakeUs);
+    fprintf(out, ",\n");
+    writeLatency(out, "request_ms", &results->requestUs);
+    fprintf(out, ",\n");
+    writeLatency(out, "ttfb_ms", &results->ttfbUs);
+    fprintf(out, "\n    }");
+}
+
+// Run all clients for one configuration and write its results.
+static void
+runBenchmark(
+    const Config_t* const config,
+    SSL_CTX* const        ctx,
+    FILE* const           out)
+{
+    Client_t* clients = calloc(config->numClients, sizeof(Client_t));
+    if (NULL == clients)
+    {
+        fprintf(stderr, "ERROR: out of memory\n");
+        exit(1);
+    }
+
+    const double start = getTimeSec();
+
+    for (unsigned int i = 0; i < config->numClients; i++)
+    {
+        clients[i].config = config;
+        snprintf(clients[i].port, sizeof(clients[i].port), "%d",
+                 atoi(config->port) + (int)(i % config->numWorkers));
+        clients[i].ctx = ctx;
+        clients[i].deadline = start + config->duration;
+        pthread_create(&clients[i].thread, NULL, runClient, &clients[i]);
+    }
+
+    Results_t total = { 0 };
+
+    for (unsigned int i = 0; i < config->numClients; i++)
+    {
+        const Results_t* const results = &clients[i].results;
+
+        pthread_join(clients[i].thread, NULL);
+
+        total.connectErrors += results->connectErrors;
+        total.handshakeErrors += results->handshakeErrors;
+        total.requestErrors += results->requestErrors;
+        total.handshakes += results->handshakes;
+        total.resumed += results->resumed;
+        total.tls13 += results->tls13;
+        total.requests += results->requests;
+        total.bytes += results->bytes;
+        mergeSamples(&total.handshakeUs, &results->handshakeUs);
+        mergeSamples(&total.requestUs, &results->requestUs);
+        mergeSamples(&total.ttfbUs, &results->ttfbUs);
+
+        free(results->handshakeUs.values);
+        free(results->requestUs.values);
+        free(results->ttfbUs.values);
+    }
+
+    const double elapsed = getTimeSec() - start;
+
+    qsort(total.handshakeUs.values, total.handshakeUs.len,
+          sizeof(unsigned long), compareSamples);
+    qsort(total.requestUs.values, total.requestUs.len,
+          sizeof(unsigned long), compareSamples);
+    qsort(total.ttfbUs.values, total.ttfbUs.len,
+          sizeof(unsigned long), compareSamples);
+
+    fprintf(stderr,
+            "%-32s %8.1f handshakes/s %8.1f requests/s  handshake p50 "
+            "%.1f ms p99 %.1f ms  request p50 %.1f ms p99 %.1f ms  "
+            "ttfb p50 %.1f ms  errors %lu/%lu/%lu\n",
+            (NULL != config->cipher) ? config->cipher : "default",
+            (double)total.handshakes / elapsed,
+            (double)total.requests / elapsed,
+            getPercentileMs(&total.handshakeUs, 50),
+            getPercentileMs(&total.handshakeUs, 99),
+            getPercentileMs(&total.requestUs, 50),
+            getPercentileMs(&total.requestUs, 99),
+            getPercentileMs(&total.ttfbUs, 50),
+            total.connectErrors,
+            total.handshakeErrors,
+            total.requestErrors);
+
+    writeResult(out, config, &total, elapsed);
+
+    free(total.handshakeUs.values);
+    free(total.requestUs.values);
+    free(total.ttfbUs.values);
+    free(clients);
+}
+
+//------------------------------------------------------------------------------
+
+static void
+printUsage(
+    const char* const name)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -s <host:port>  server (default %s)\n"
+            "  -c <clients>    concurrent clients (default %u)\n"
+            "  -w <workers>    spread clients over this many consecutive "
+            "ports (default 1)\n"
+            "  -d <seconds>    duration per cipher suite (default %u)\n"
+            "  -r <requests>   requests per connection, 1 to close after "
+            "every request (default %u)\n"
+            "  -p <path>       requested path (default %s)\n"
+            "  -C <cipher>     OpenSSL cipher suite, repeat for a sweep\n"
+            "  -R              resume sessions\n"
+            "  -V <version>    highest TLS version offered, 1.2 or 1.3 "
+            "(default 1.2)\n"
+            "  -k <dir>        certificates (default %s)\n"
+            "  -v              verify the server certificate against the CA "
+            "in <dir>\n"
+            "  -o <file>       write JSON results to file (default stdout)\n",
+            name, DEFAULT_SERVER, DEFAULT_CLIENTS, DEFAULT_DURATION,
+            DEFAULT_REQUESTS, DEFAULT_PATH, CERTS_DIR);
+}
+
+int
+main(
+    int   argc,
+    char* argv[])
+{
+    static char server[256] = DEFAULT_SERVER;
+    const char* ciphers[MAX_CIPHERS];
+    size_t numCiphers = 0;
+    const char* outFile = NULL;
+
+    Config_t config =
+    {
+        .path                  = DEFAULT_PATH,
+        .certsDir              = CERTS_DIR,
+        .numClients            = DEFAULT_CLIENTS,
+        .numWorkers            = 1,
+        .duration              = DEFAULT_DURATION,
+        .requestsPerConnection = DEFAULT_REQUESTS,
+        .maxVersion            = TLS1_2_VERSION,
+        // The demo certificates have expired, verification is opt-in.
+        .isVerify              = false,
+    };
+
+    // A server rejecting connections closes them under our feet, which must
+    // count as an error instead of killing the process.
+    signal(SIGPIPE, SIG_IGN);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:c:w:d:r:p:C:RV:k:vo:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            snprintf(server, sizeof(server), "%s", optarg);
+            break;
+        case 'c':
+            config.numClients = (unsigned int)atoi(optarg);
+            break;
+        case 'w':
+            config.numWorkers = (unsigned int)atoi(optarg);
+            break;
+        case 'd':
+            config.duration = (unsigned int)atoi(optarg);
+            break;
+        case 'r':
+            config.requestsPerConnection = (unsigned int)atoi(optarg);
+            break;
+        case 'p':
+            config.path = optarg;
+            break;
+        case 'C':
+            if (numCiphers == MAX_CIPHERS)
+            {
+                fprintf(stderr, "ERROR: too many cipher suites\n");
+                return 1;
+            }
+            ciphers[numCiphers++] = optarg;
+            break;
+        case 'R':
+            config.isResume = true;
+            break;
+        case 'V':
+            if (0 == strcmp(optarg, "1.2"))
+            {
+                config.maxVersion = TLS1_2_VERSION;
+            }
+            else if (0 == strcmp(optarg, "1.3"))
+            {
+                config.maxVersion = TLS1_3_VERSION;
+            }
+            else
+            {
+                printUsage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'k':
+            config.certsDir = optarg;
+            break;
+        case 'v':
+            config.isVerify = true;
+            break;
+        case 'o':
+            outFile = optarg;
+            break;
+        default:
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    char* colon = strrchr(server, ':');
+    if ((NULL == colon) || (0 == config.numClients) || (0 == config.numWorkers)
+        || (0 == config.duration) || (0 == config.requestsPerConnection))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    *colon = '\0';
+    config.host = server;
+    config.port = colon + 1;
+
+    FILE* out = stdout;
+    if ((NULL != outFile) && (NULL == (out = fopen(outFile, "w"))))
+    {
+        fprintf(stderr, "ERROR: cannot open %s\n", outFile);
+        return 1;
+    }
+
+    fprintf(out,
+            "{\n"
+            "  \"server\": \"%s:%s\",\n"
+            "  \"path\": \"%s\",\n"
+            "  \"results\": [\n",
+            config.host, config.port, config.path);
+
+    // Without -C the default cipher list of OpenSSL is offered.
+    if (0 == numCiphers)
+    {
+        ciphers[numCiphers++] = NULL;
+    }
+
+    int ret = 0;
+    for (size_t i = 0; i < numCiphers; i++)
+    {
+        config.cipher = ciphers[i];
+
+        SSL_CTX* ctx = createContext(&config);
+        if (NULL == ctx)
+        {
+            fprintf(stderr, "ERROR: cannot set up TLS for cipher %s\n",
+                    (NULL != config.cipher) ? config.cipher : "default");
+            ret = 1;
+            break;
+        }
+
+        if (i > 0)
+        {
+            fprintf(out, ",\n");
+        }
+        runBenchmark(&config, ctx, out);
+
+        SSL_CTX_free(ctx);
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    return ret;
+}
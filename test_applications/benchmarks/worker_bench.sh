@@ -0,0 +1,139 @@
+#!/bin/bash -eu
+
+#-------------------------------------------------------------------------------
+#
+# Copyright (C) 2021-2024, HENSOLDT Cyber GmbH
+# 
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# For commercial licensing, contact: info.cyber@hensoldt.net
+#
+# Measure the full TLS handshakes per second of the host build of the TLS
+# server for different numbers of worker instances.
+#-------------------------------------------------------------------------------
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" >/dev/null 2>&1 && pwd)"
+
+#-------------------------------------------------------------------------------
+function print_usage_help()
+{
+    echo "Usage: $(basename $0) [-h|-b <build dir>|-l <build dir>|-c <clients>"
+    echo "       |-t <seconds>] [<workers>...]"
+    echo "  -h : Show usage info (optional)."
+    echo "  -b : Build directory of the host build of the TLS server (optional,"
+    echo "       default build-host)."
+    echo "  -l : Build directory of the benchmarks (optional, default"
+    echo "       build-benchmarks)."
+    echo "  -c : Concurrent clients (optional, default 16)."
+    echo "  -t : Seconds per run (optional, default 20)."
+    echo "  workers : Numbers of workers to measure (optional, default 1 2 4)."
+}
+
+#-------------------------------------------------------------------------------
+function print_err()
+{
+    local MSG=$1
+    echo "ERROR: ${MSG}" >&2
+}
+
+#-------------------------------------------------------------------------------
+function stop_workers()
+{
+    if [ ${#WORKER_PIDS[@]} -gt 0 ]; then
+        kill ${WORKER_PIDS[@]} 2>/dev/null || true
+        wait ${WORKER_PIDS[@]} 2>/dev/null || true
+    fi
+    WORKER_PIDS=()
+}
+
+#-------------------------------------------------------------------------------
+# Arguments
+#-------------------------------------------------------------------------------
+
+SERVER_BUILD_DIR="build-host"
+BENCH_BUILD_DIR="build-benchmarks"
+CLIENTS=16
+SECONDS_PER_RUN=20
+
+while getopts ":hb:l:c:t:" ARG; do
+    case "${ARG}" in
+        h)
+            print_usage_help
+            exit 0
+            ;;
+        b)
+            SERVER_BUILD_DIR=${OPTARG}
+            ;;
+        l)
+            BENCH_BUILD_DIR=${OPTARG}
+            ;;
+        c)
+            CLIENTS=${OPTARG}
+            ;;
+        t)
+            SECONDS_PER_RUN=${OPTARG}
+            ;;
+        \?)
+            print_err "invalid parameter ${OPTARG}"
+            print_usage_help
+            exit 1
+            ;;
+        :)
+            print_err "incomplete parameter ${OPTARG}"
+            print_usage_help
+            exit 1
+            ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+WORKER_COUNTS=("$@")
+if [ ${#WORKER_COUNTS[@]} -eq 0 ]; then
+    WORKER_COUNTS=(1 2 4)
+fi
+
+SERVER=${SERVER_BUILD_DIR}/tls_server_host
+LOAD_GEN=${BENCH_BUILD_DIR}/tls_load_gen
+
+for BINARY in ${SERVER} ${LOAD_GEN}; do
+    if [ ! -x ${BINARY} ]; then
+        print_err "${BINARY} not found, see README.md"
+        exit 1
+    fi
+done
+
+#-------------------------------------------------------------------------------
+# Handshakes
+#-------------------------------------------------------------------------------
+
+WORKER_PIDS=()
+trap stop_workers EXIT
+
+printf "%-8s %12s %10s %14s %8s\n" "workers" "handshakes" "seconds" \
+    "handshakes/s" "errors"
+
+for WORKERS in "${WORKER_COUNTS[@]}"
+do
+    # Worker i listens on port 5560 + i, the load generator spreads the clients
+    # over the ports as the NAT of the test container does on the target.
+    for ((i = 0; i < WORKERS; i++)); do
+        ${SERVER} ${i} >/dev/null 2>&1 &
+        WORKER_PIDS+=($!)
+    done
+    sleep 1
+
+    # Every connection performs a full handshake including client
+    # authentication and a single request.
+    RESULT=$(${LOAD_GEN} -s 127.0.0.1:5560 -r 1 -w ${WORKERS} \
+        -c ${CLIENTS} -d ${SECONDS_PER_RUN} \
+        -C ECDHE-RSA-AES128-GCM-SHA256)
+
+    stop_workers
+
+    # Pick the numbers from the JSON result, one value per line.
+    echo "${RESULT}" | awk -v w=${WORKERS} -F '[:,]' '
+        /"seconds"/    { t = $2 }
+        /"handshakes"/ { n = $2 }
+        /_errors"/     { e += $2 }
+        END { printf "%-8d %12d %10.1f %14.2f %8d\n", w, n, t, n / t, e }'
+done
@@ -17,10 +17,11 @@ SCRIPT_DIR="$(cd "$(dirname "$0")" >/dev/null 2>&1 && pwd)"
 #-------------------------------------------------------------------------------
 function print_usage_help()
 {
-    echo "Usage: $(basename $0) [-h|-v|-r]"
+    echo "Usage: $(basename $0) [-h|-v|-r|-e]"
     echo "  -h : Show usage info (optional)."
     echo "  -v : Print and verify certificates (optional)."
     echo "  -r : Create new root certificate (optional)."
+    echo "  -e : Create additional P-256 ECDSA server certificate (optional)."
 }
 
 #-------------------------------------------------------------------------------
@@ -36,9 +37,10 @@ function print_err()
 
 VERIFY=0
 CREATE_NEW_ROOT=0
+CREATE_ECDSA=0
 
 if [ $# -ge 1 ]; then
-    while getopts ":hvr" ARG; do
+    while getopts ":hvre" ARG; do
         case "${ARG}" in
             h)
                 print_usage_help
@@ -50,6 +52,9 @@ if [ $# -ge 1 ]; then
             r)
                 CREATE_NEW_ROOT=1
                 ;;
+            e)
+                CREATE_ECDSA=1
+                ;;
             \?)
                 print_err "invalid parameter ${OPTARG}"
                 print_usage_help
@@ -97,6 +102,23 @@ openssl req -new -key server.key -out server.csr \
 openssl x509 -req -in server.csr -CA CA.crt -CAkey CA.key -CAcreateserial \
     -out server.crt -days 365 -sha256 -extfile ../server_cert.ext
 
+#-------------------------------------------------------------------------------
+# ECDSA server certificate
+#-------------------------------------------------------------------------------
+
+if [ ${CREATE_ECDSA} -eq 1 ]; then
+
+    openssl ecparam -name prime256v1 -genkey -noout -out server_ecdsa.key
+
+    openssl req -new -key server_ecdsa.key -out server_ecdsa.csr \
+        -subj "/C=DE/ST=Bayern/L=Ottobrunn/O=HENSOLDT Cyber GmbH/CN=dev-hc-server"
+
+    openssl x509 -req -in server_ecdsa.csr -CA CA.crt -CAkey CA.key \
+        -CAcreateserial -out server_ecdsa.crt -days 365 -sha256 \
+        -extfile ../server_cert.ext
+
+fi
+
 #-------------------------------------------------------------------------------
 # Client certificate
 #-------------------------------------------------------------------------------
@@ -123,4 +145,9 @@ if [ ${VERIFY} -eq 1 ]; then
 
     openssl verify -CAfile CA.crt server.crt
     openssl verify -CAfile CA.crt client.crt
+
+    if [ ${CREATE_ECDSA} -eq 1 ]; then
+        openssl x509 -noout -text -in server_ecdsa.crt
+        openssl verify -CAfile CA.crt server_ecdsa.crt
+    fi
 fi
@@ -8,7 +8,7 @@
 #
 # For commercial licensing, contact: info.cyber@hensoldt.net
 #
-# Enumerate and test OpenSSL cipher suites.
+# Enumerate and test OpenSSL cipher suites of TLS 1.2 and TLS 1.3.
 #-------------------------------------------------------------------------------
 
 
@@ -41,6 +41,28 @@ do
     echo
 done
 
+# TLS 1.3 suites are configured separately from the TLS 1.2 cipher list.
+CIPHERS_TLS13=(TLS_AES_128_GCM_SHA256 TLS_AES_256_GCM_SHA384
+    TLS_CHACHA20_POLY1305_SHA256 TLS_AES_128_CCM_SHA256)
+
+for CIPHER in ${CIPHERS_TLS13[@]}
+do
+    echo -n "Testing $CIPHER (TLS 1.3)... "
+
+    RESULT=$(echo -n | openssl s_client -tls1_3 \
+        -CAfile certs/CA.crt -cert certs/client.crt -key certs/client.key \
+        -connect 172.17.0.1:5560 \
+        -ciphersuites $CIPHER 2>&1)
+
+    if [[ "$RESULT" =~ "Cipher is ${CIPHER}" ]]
+    then
+        echo -n "*** OK ***"
+        CIPHERS_SUPPORTED+=($CIPHER)
+    fi
+
+    echo
+done
+
 echo
 echo "Supported cipher suites:"
 